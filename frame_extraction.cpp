@@ -419,7 +419,7 @@ static int initial_crop(Mat in_frame, int framecnt) {
  * @return touching_status an integer value representing if and which edge of the frame is touched
  * by the contour.  Returns negative status values if something went wrong.
  */
-static int touching_edges(Mat in_frame, vector<Point> contour) {
+static int touching_edges(Mat in_frame, Mat contour) {
 	// fetch the boundary rectangle for our large contour
 	Rect box = boundingRect(contour);
 
@@ -453,7 +453,7 @@ static int touching_edges(Mat in_frame, vector<Point> contour) {
 	return -1;
 }
 
-static Mat traditional_centering(Mat in_frame, vector <vector<Point>> contours, int largest, Rect box) {
+static Mat traditional_centering(Mat in_frame, const ContourSet &contours, int largest, Rect box) {
 	// Generate masks
 	Mat mask(Size(in_frame.rows, in_frame.cols), in_frame.type(), Scalar(0));
 	Mat zero_mask(Size(BOXSIZE, BOXSIZE), in_frame.type(), Scalar(0));
@@ -461,7 +461,7 @@ static Mat traditional_centering(Mat in_frame, vector <vector<Point>> contours,
 	Mat item(in_frame(box));
 
 	// Apply contour to mask
-	drawContours(mask, contours, largest, 255, FILLED);
+	drawContours(mask, vector <Mat>(1, contours[largest]), 0, 255, FILLED);
 
 	// Transfer item to mask
 	item.copyTo(item, mask(box));
@@ -500,7 +500,7 @@ static int first_frame(Mat in_frame, int framecnt) {
 	// Make sure the black of night stays black so we can get the edge of the moon
 	threshold(in_frame.clone(), temp_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
 	// Get contours
-	vector <vector<Point>> contours = contours_only(temp_frame);
+	ContourSet contours = contours_only(temp_frame, CHAIN_APPROX_NONE);
 
 	if (DEBUG_COUT) {
 		LOGGING.open(LOGOUT, std::ios_base::app);
@@ -513,7 +513,7 @@ static int first_frame(Mat in_frame, int framecnt) {
 
 	// Find which contour is the largest
 	int largest_contour_index = largest_contour(contours);
-	drawContours(in_frame, contours, largest_contour_index, 255, 2, LINE_8);
+	drawContours(in_frame, vector <Mat>(1, contours[largest_contour_index]), 0, 255, 2, LINE_8);
 
 	// Store original area and perimeter of first frame
 	Rect box = boundingRect(contours[largest_contour_index]);
@@ -652,9 +652,14 @@ static int halo_noise_and_center(Mat in_frame, int framecnt) {
 	in_frame = IC_FRAME;
 	// Make sure the black of night stays black so we can get the edge of the moon
 	threshold(in_frame.clone(), temp_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
-	vector <vector<Point>> contours = contours_only(temp_frame);
+	ContourSet contours = contours_only(temp_frame, CHAIN_APPROX_NONE);
 	int largest = largest_contour(contours);
+	if (largest < 0) {
+		return 1;
+	}
 	Rect box = boundingRect(contours[largest]);
+	// Corner matching walks every point of the edge
+	vector <Point> moon = contours.copy(largest);
 
 	int edge_top = 0;
 	int edge_bot = 0;
@@ -669,15 +674,15 @@ static int halo_noise_and_center(Mat in_frame, int framecnt) {
 			LOGGING << "Activating Corner Matching" << std::endl;
 			LOGGING.close();
 		}
-		vector <int> outplus = test_edges(in_frame, contours[largest], te_ret);
+		vector <int> outplus = test_edges(in_frame, moon, te_ret);
 		in_frame = shift_frame(in_frame, outplus[0], outplus[1]);
 		if ((outplus[0] > 0) || (outplus[0] < 0)) {
-			vector <int> local_edge = edge_width(contours[largest]);
+			vector <int> local_edge = edge_width(moon);
 			edge_top = local_edge[0];
 			edge_bot = local_edge[1];
 		}
 		if ((outplus[1] > 0) || (outplus[1] < 0)) {
-			vector <int> local_edge = edge_height(contours[largest]);
+			vector <int> local_edge = edge_height(moon);
 			edge_lef = local_edge[0];
 			edge_rig = local_edge[1];
 		}
@@ -725,13 +730,73 @@ static int halo_noise_and_center(Mat in_frame, int framecnt) {
 	<< std::endl;
 	outell.close();
 
+	// The Tiers filter views into this frame, which read the pixels past their edge, so it must not
+	// be a view itself.  Only an uncentered crop from initial_crop() is.
+	if (in_frame.isSubmatrix()) {
+		in_frame = in_frame.clone();
+	}
 	HNC_FRAME = in_frame;
 	return 0;
 }
 
 /**
- * This is a helper function to handle terminal signals.  This shuts down the various forks properly
- * when an interrupt is caught.
+ * Cheap check of whether the moon is back after it was lost.  The frame is scanned at
+ * 1/REACQUIRE_SCALE resolution, and the moon counts as found again when the bounding box of the
+ * largest bright contour covers at least REACQUIRE_FRACTION of the moon's box in the first frame.
+ * Only then is the frame handed to halo_noise_and_center.
+ *
+ * @param in_frame OpenCV matrix image, 16-bit single depth format, uncropped
+ * @param moon_area area of the moon's bounding box in the first frame
+ * @return true if the moon looks visible again
+ */
+static bool moon_reacquired(Mat in_frame, int moon_area) {
+	int scale = std::max(1, REACQUIRE_SCALE);
+	Mat small_frame;
+	resize(in_frame, small_frame, Size(), 1.0/scale, 1.0/scale, INTER_AREA);
+	threshold(small_frame.clone(), small_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
+	ContourSet contours = contours_only(small_frame, CHAIN_APPROX_SIMPLE);
+	int largest = largest_contour(contours);
+	if (largest < 0) {
+		return false;
+	}
+	double area = static_cast<double>(boundingRect(contours[largest]).area()) * scale * scale;
+	return area >= REACQUIRE_FRACTION * moon_area;
+}
+
+/**
+ * Appends a span of frames where the moon was lost to MOONLOSTDATA.
+ *
+ * @param first_frame first frame without the moon
+ * @param last_frame last frame without the moon
+ * @param reacquired true if the moon was found again after last_frame
+ * @return status
+ */
+static int moon_lost_data(int first_frame, int last_frame, bool reacquired) {
+	std::ofstream outfile;
+	outfile.open(MOONLOSTDATA, std::ios_base::app);
+	outfile
+	<< first_frame
+	<< ","
+	<< last_frame
+	<< ","
+	<< last_frame - first_frame + 1
+	<< ","
+	<< reacquired
+	<< std::endl;
+	outfile.close();
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Moon lost from frame " << first_frame << " to " << last_frame
+		<< (reacquired ? ", reacquired" : ", not reacquired") << std::endl;
+		LOGGING.close();
+	}
+	return 0;
+}
+
+/**
+ * This is a helper function to handle terminal signals.  The main loop stops fetching frames and
+ * lets the worker threads finish when an interrupt is caught.
  *
  * @param signum signal number passed to this function. Only handles 2.
  */
@@ -752,12 +817,13 @@ void signal_callback_handler(int signum) {
  * @param contour OpenCV Point vectors of int-int point contour edges.  Use the output from "bigone"
  * here.
  * @param maskwidth
+ * @param offset position of in_frame within the frame the contour was found in
  * @return in_frame The modified in_frame from the input params
  */
-static Mat apply_dynamic_mask(Mat in_frame, vector <Point> contour, int maskwidth) {
-	vector <vector <Point>> contours;
-	contours.push_back(contour);
-	drawContours(in_frame, contours, 0, 0, maskwidth, LINE_8);
+static Mat apply_dynamic_mask(Mat in_frame, const vector <Point> &contour, int maskwidth, Point offset) {
+	// A Mat header over the points, so the contour is not copied to draw it
+	drawContours(in_frame, vector <Mat>(1, Mat(contour)), 0, 0, maskwidth, LINE_8, noArray(), INT_MAX,
+		-offset);
 	return in_frame;
 }
 
@@ -765,10 +831,10 @@ static Mat apply_dynamic_mask(Mat in_frame, vector <Point> contour, int maskwidt
  * This function returns the index of the largest contour in a list of contours so it can be accessed
  * in future functions.
  *
- * @param contours vector of OpenCV vectors of int-int point contour edges
- * @return largest_contour_index integer index of the largest contour in a vector of contour vectors
+ * @param contours ContourSet of the image
+ * @return largest_contour_index integer index of the largest contour in the set
  */
-static int largest_contour(vector <vector<Point>> contours) {
+static int largest_contour(const ContourSet &contours) {
 	int largest_contour_index = -1;
 	int largest_area = 0;
 
@@ -786,18 +852,86 @@ static int largest_contour(vector <vector<Point>> contours) {
 
 /**
  * This function returns the contours from an image.  It really only needs to exist because
- * repeatedly declaring the unused hierarchy is tedious.
+ * repeatedly declaring the unused hierarchy is tedious.  findContours() writes into the worker's
+ * scratch lists, which keep their memory from call to call, and the points are then copied once into
+ * one ContourSet.
+ *
+ * Use CHAIN_APPROX_SIMPLE where only the area, bounds, moments or enclosing circle of a contour are
+ * needed: it keeps only the ends of straight runs, so those are unchanged for a fraction of the
+ * points.  Use CHAIN_APPROX_NONE where every edge point is walked, as for bigone.
  *
  * @param in_frame OpenCV matrix image, 16-bit single depth format
- * @return vector of int-int OpenCV Point vectors for each contour detected in the in_frame
+ * @param method OpenCV contour approximation, CHAIN_APPROX_NONE or CHAIN_APPROX_SIMPLE
+ * @return ContourSet of every contour detected in the in_frame
  */
-static vector <vector<Point>> contours_only(Mat in_frame) {
-	vector <vector<Point>> contours;
-	vector<Vec4i> hierarchy;
-	findContours(in_frame, contours, hierarchy, RETR_TREE, CHAIN_APPROX_NONE);
+static ContourSet contours_only(const Mat &in_frame, int method) {
+	TierContext &scratch = SCRATCH;
+	findContours(in_frame, scratch.found, scratch.hierarchy, RETR_TREE, method);
+	ContourSet contours;
+	contours.assign(scratch.found);
 	return contours;
 }
 
+/**
+ * Creates an empty set.
+ */
+ContourSet::ContourSet() {
+}
+
+/**
+ * Replaces the set with a copy of a list of contours, such as the output of findContours().  The
+ * contours keep their order.
+ *
+ * @param contours vector of OpenCV vectors of int-int point contour edges
+ */
+void ContourSet::assign(const vector <vector<Point>> &contours) {
+	size_t total = 0;
+	for (auto &contour : contours) {
+		total += contour.size();
+	}
+	points.clear();
+	points.reserve(total);
+	spans.clear();
+	spans.reserve(contours.size());
+	for (auto &contour : contours) {
+		int start = static_cast<int>(points.size());
+		spans.push_back(std::make_pair(start, static_cast<int>(contour.size())));
+		points.insert(points.end(), contour.begin(), contour.end());
+	}
+}
+
+/**
+ * @return number of contours in the set
+ */
+size_t ContourSet::size() const {
+	return spans.size();
+}
+
+/**
+ * @param i index of the contour
+ * @return number of points in contour i
+ */
+int ContourSet::count(size_t i) const {
+	return spans[i].second;
+}
+
+/**
+ * @param i index of the contour
+ * @return Mat header over the points of contour i
+ */
+Mat ContourSet::operator[](size_t i) const {
+	return Mat(count(i), 1, CV_32SC2, const_cast<Point *>(points.data() + spans[i].first));
+}
+
+/**
+ * @param i index of the contour
+ * @return the points of contour i, for the functions which walk them as a vector
+ */
+vector <Point> ContourSet::copy(size_t i) const {
+	auto first = points.begin() + spans[i].first;
+	return vector <Point>(first, first + spans[i].second);
+}
+
 /**
  * This function finds the bounding box for the largest contour and reports on its properties.  Stores
  * OpenCV Rect object bounding the largest contour (presumably the moon) to global BF_BOX.
@@ -811,7 +945,7 @@ static int box_finder(Mat in_frame, bool do_thresh) {
 	if (do_thresh) {
 		threshold(in_frame.clone(), in_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
 	}
-	vector <vector<Point>> contours = contours_only(in_frame);
+	ContourSet contours = contours_only(in_frame, CHAIN_APPROX_SIMPLE);
 
 	if (DEBUG_COUT) {
 		LOGGING.open(LOGOUT, std::ios_base::app);
@@ -827,6 +961,9 @@ static int box_finder(Mat in_frame, bool do_thresh) {
 	}
 
 	int largest_contour_index = largest_contour(contours);
+	if (largest_contour_index < 0) {
+		return 1;
+	}
 
 	// Find the bounding box for the large contour
 	BF_BOX = boundingRect(contours[largest_contour_index]);
@@ -877,33 +1014,369 @@ static int show_usage(string name) {
 			<< "\t-i,--input\t\tINPUT\tSpecify path to input video\n"
 			<< "\t-c,--config-file \tINPUT\tSpecify config file (default settings.cfg)\n"
 			<< "\t-osf,--osf-path \tINPUT\tSpeify path to osf video\n"
+			<< "\t-q,--quick-look\t\t\tOnly sample the video and write a per minute summary\n"
+			<< "\t-t,--self-test\t\t\tCheck the approximate kernels against the exact ones and exit\n"
 			<< std::endl;
 	return 0;
 }
 
+/**
+ * GaussianBlur with the kernel size chosen at run time.  Used unless RECURSIVE_BLUR is set.
+ *
+ * @param in_frame OpenCV matrix image
+ * @param out_frame OpenCV matrix image which receives the blurred image
+ * @param ksize kernel size
+ * @param sigma_x Gaussian sigma in x
+ * @param sigma_y Gaussian sigma in y
+ */
+static void blur_generic(Mat in_frame, Mat &out_frame, Size ksize, double sigma_x, double sigma_y) {
+	GaussianBlur(in_frame, out_frame, ksize, sigma_x, sigma_y, BORDER_DEFAULT);
+}
+
+/**
+ * Young-van Vliet recursive Gaussian filter along one line of floats, in place.  A third order causal
+ * pass runs forward and an anti-causal one backward, so the cost does not depend on sigma.  Both
+ * passes start from the steady state of the edge value, which behaves like replicated borders.
+ *
+ * @param line first element of the line
+ * @param count number of elements
+ * @param step distance between elements
+ * @param coeffs B, b1/b0, b2/b0 and b3/b0 from recursive_coeffs()
+ */
+static void recursive_line(float *line, int count, int step, const double *coeffs) {
+	double scale = coeffs[0];
+	double a1 = coeffs[1];
+	double a2 = coeffs[2];
+	double a3 = coeffs[3];
+	// Forward pass
+	double w1 = line[0];
+	double w2 = w1;
+	double w3 = w1;
+	for (int i = 0; i < count; i++) {
+		double w0 = scale * line[i * step] + a1 * w1 + a2 * w2 + a3 * w3;
+		line[i * step] = static_cast<float>(w0);
+		w3 = w2;
+		w2 = w1;
+		w1 = w0;
+	}
+	// Backward pass
+	w1 = line[(count - 1) * step];
+	w2 = w1;
+	w3 = w1;
+	for (int i = count - 1; i >= 0; i--) {
+		double w0 = scale * line[i * step] + a1 * w1 + a2 * w2 + a3 * w3;
+		line[i * step] = static_cast<float>(w0);
+		w3 = w2;
+		w2 = w1;
+		w1 = w0;
+	}
+}
+
+/**
+ * Coefficients of the Young-van Vliet recursive Gaussian for a sigma of at least 0.5.
+ *
+ * @param sigma Gaussian sigma
+ * @param coeffs receives B, b1/b0, b2/b0 and b3/b0
+ */
+static void recursive_coeffs(double sigma, double *coeffs) {
+	double q;
+	if (sigma >= 2.5) {
+		q = 0.98711 * sigma - 0.96330;
+	} else {
+		q = 3.97156 - 4.14554 * sqrt(1 - 0.26891 * sigma);
+	}
+	double b0 = 1.57825 + 2.44413 * q + 1.4281 * q * q + 0.422205 * q * q * q;
+	double b1 = 2.44413 * q + 2.85619 * q * q + 1.26661 * q * q * q;
+	double b2 = -(1.4281 * q * q + 1.26661 * q * q * q);
+	double b3 = 0.422205 * q * q * q;
+	coeffs[0] = 1 - (b1 + b2 + b3) / b0;
+	coeffs[1] = b1 / b0;
+	coeffs[2] = b2 / b0;
+	coeffs[3] = b3 / b0;
+}
+
+/**
+ * Recursive (IIR) Gaussian blur, a drop in for GaussianBlur whose cost does not depend on the kernel
+ * size or sigma.  As with GaussianBlur, a sigma of 0 is worked out from the kernel size, but the
+ * recursive filter is not cut off at the kernel size and treats the borders as replicated, so the
+ * result differs slightly from GaussianBlur (check_recursive_blur() checks by how much).  Sigmas below
+ * 0.5 and multi channel images use GaussianBlur.
+ *
+ * @param in_frame OpenCV matrix image
+ * @param out_frame OpenCV matrix image which receives the blurred image
+ * @param ksize kernel size, only read when a sigma is 0
+ * @param sigma_x Gaussian sigma in x
+ * @param sigma_y Gaussian sigma in y
+ */
+static void blur_recursive(Mat in_frame, Mat &out_frame, Size ksize, double sigma_x, double sigma_y) {
+	if (sigma_x <= 0) {
+		sigma_x = 0.3 * ((ksize.width - 1) * 0.5 - 1) + 0.8;
+	}
+	if (sigma_y <= 0) {
+		sigma_y = (ksize.height == ksize.width) ? sigma_x : 0.3 * ((ksize.height - 1) * 0.5 - 1) + 0.8;
+	}
+	if ((in_frame.channels() != 1) || (sigma_x < 0.5) || (sigma_y < 0.5)) {
+		blur_generic(in_frame, out_frame, ksize, sigma_x, sigma_y);
+		return;
+	}
+	double coeffs_x[4];
+	double coeffs_y[4];
+	recursive_coeffs(sigma_x, coeffs_x);
+	recursive_coeffs(sigma_y, coeffs_y);
+
+	Mat result;
+	in_frame.convertTo(result, CV_32F);
+	int rows = result.rows;
+	int cols = result.cols;
+	for (int y = 0; y < rows; y++) {
+		recursive_line(result.ptr<float>(y), cols, 1, coeffs_x);
+	}
+	// The columns are filtered a whole row at a time to stay cache friendly.  The first row of each
+	// pass is its own steady state, so clamping the earlier rows to it starts the passes as
+	// recursive_line() does.
+	float scale = static_cast<float>(coeffs_y[0]);
+	float a1 = static_cast<float>(coeffs_y[1]);
+	float a2 = static_cast<float>(coeffs_y[2]);
+	float a3 = static_cast<float>(coeffs_y[3]);
+	for (int y = 0; y < rows; y++) {
+		float *w0 = result.ptr<float>(y);
+		const float *w1 = result.ptr<float>(std::max(y - 1, 0));
+		const float *w2 = result.ptr<float>(std::max(y - 2, 0));
+		const float *w3 = result.ptr<float>(std::max(y - 3, 0));
+		for (int x = 0; x < cols; x++) {
+			w0[x] = scale * w0[x] + a1 * w1[x] + a2 * w2[x] + a3 * w3[x];
+		}
+	}
+	for (int y = rows - 1; y >= 0; y--) {
+		float *w0 = result.ptr<float>(y);
+		const float *w1 = result.ptr<float>(std::min(y + 1, rows - 1));
+		const float *w2 = result.ptr<float>(std::min(y + 2, rows - 1));
+		const float *w3 = result.ptr<float>(std::min(y + 3, rows - 1));
+		for (int x = 0; x < cols; x++) {
+			w0[x] = scale * w0[x] + a1 * w1[x] + a2 * w2[x] + a3 * w3[x];
+		}
+	}
+	result.convertTo(out_frame, in_frame.type());
+}
+
+/**
+ * Checks how far blur_recursive() is from GaussianBlur for one kernel from settings.cfg, on a test
+ * image of a bright disc over a noisy ramp.  Fails when any pixel differs by more than
+ * RECURSIVE_BLUR_TOLERANCE 8-bit levels, or the mean difference is more than
+ * RECURSIVE_BLUR_MEAN_TOLERANCE.
+ *
+ * @param name name of the blur in the log
+ * @param ksize kernel size
+ * @param sigma_x Gaussian sigma in x
+ * @param sigma_y Gaussian sigma in y
+ * @return status
+ */
+static int check_recursive_blur(std::string name, Size ksize, double sigma_x, double sigma_y) {
+	Mat test_frame(256, 256, CV_8UC1);
+	for (int y = 0; y < test_frame.rows; y++) {
+		uchar *pixel = test_frame.ptr<uchar>(y);
+		for (int x = 0; x < test_frame.cols; x++) {
+			pixel[x] = saturate_cast<uchar>(x / 4 + ((x * 7 + y * 13) % 32));
+		}
+	}
+	circle(test_frame, Point(128, 128), 64, Scalar(230), FILLED);
+	Mat reference, recursive, difference;
+	GaussianBlur(test_frame, reference, ksize, sigma_x, sigma_y, BORDER_DEFAULT);
+	blur_recursive(test_frame, recursive, ksize, sigma_x, sigma_y);
+	absdiff(reference, recursive, difference);
+	double max_difference;
+	minMaxLoc(difference, NULL, &max_difference);
+	double mean_difference = mean(difference)[0];
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Recursive " << name << " blur differs from GaussianBlur by at most " << max_difference
+		<< ", mean " << mean_difference << " (8-bit levels)"
+		<< std::endl;
+		LOGGING.close();
+	}
+	int status = 0;
+	if (max_difference > RECURSIVE_BLUR_TOLERANCE) {
+		std::cerr
+		<< "WARNING: Recursive " << name << " blur differs from GaussianBlur by " << max_difference
+		<< " levels, more than RECURSIVE_BLUR_TOLERANCE"
+		<< std::endl;
+		status = 1;
+	}
+	if (mean_difference > RECURSIVE_BLUR_MEAN_TOLERANCE) {
+		std::cerr
+		<< "WARNING: Recursive " << name << " blur differs from GaussianBlur by " << mean_difference
+		<< " levels on average, more than RECURSIVE_BLUR_MEAN_TOLERANCE"
+		<< std::endl;
+		status = 1;
+	}
+	return status;
+}
+
+/**
+ * Inverted Gaussian adaptiveThreshold with the block size chosen at run time.  Used unless the Tier
+ * asks for the box mean threshold.
+ *
+ * @param in_frame OpenCV matrix image, 8-bit single channel
+ * @param out_frame OpenCV matrix image which receives the binary mask
+ * @param maxval value given to pixels passing the threshold
+ * @param blocksize size of the neighbourhood
+ * @param constant subtracted from the neighbourhood mean
+ */
+static void threshold_generic(Mat in_frame, Mat &out_frame, double maxval, int blocksize, double constant) {
+	adaptiveThreshold(in_frame, out_frame,
+		maxval,
+		ADAPTIVE_THRESH_GAUSSIAN_C,
+		THRESH_BINARY_INV,
+		blocksize,
+		constant
+	);
+}
+
+/**
+ * Inverted mean adaptive threshold on an integral image.  The neighbourhood mean is the plain mean of
+ * the blocksize by blocksize box with replicated borders, read from the integral image with four
+ * lookups, so the cost per pixel does not depend on blocksize.  A pixel passes when it is at least
+ * constant below the mean.  The compare is done on the box sums in integers, without a division,
+ * and has no branches so the compiler can vectorize it.  The box mean is flatter than the Gaussian
+ * one, so the Tier's constant usually needs retuning when this is selected.
+ *
+ * @param in_frame OpenCV matrix image, 8-bit single channel
+ * @param out_frame OpenCV matrix image which receives the binary mask
+ * @param maxval value given to pixels passing the threshold
+ * @param blocksize size of the neighbourhood
+ * @param constant subtracted from the neighbourhood mean
+ */
+static void threshold_box(Mat in_frame, Mat &out_frame, double maxval, int blocksize, double constant) {
+	if (in_frame.type() != CV_8UC1) {
+		threshold_generic(in_frame, out_frame, maxval, blocksize, constant);
+		return;
+	}
+	int half = blocksize / 2;
+	Mat padded, sums;
+	copyMakeBorder(in_frame, padded, half, half, half, half, BORDER_REPLICATE);
+	integral(padded, sums, CV_32S);
+	// src - sum/area <= -constant  is  src*area + constant*area <= sum
+	int area = blocksize * blocksize;
+	int delta = cvFloor(constant) * area;
+	uchar imaxval = saturate_cast<uchar>(maxval);
+	// Each pixel only reads its own input pixel, so out_frame keeps its buffer and may be in_frame
+	out_frame.create(in_frame.size(), CV_8UC1);
+	for (int y = 0; y < in_frame.rows; y++) {
+		const uchar *src = in_frame.ptr<uchar>(y);
+		const int *top = sums.ptr<int>(y);
+		const int *bottom = sums.ptr<int>(y + blocksize);
+		uchar *dst = out_frame.ptr<uchar>(y);
+		for (int x = 0; x < in_frame.cols; x++) {
+			int sum = bottom[x + blocksize] - bottom[x] - top[x + blocksize] + top[x];
+			dst[x] = (src[x] * area + delta <= sum) ? imaxval : 0;
+		}
+	}
+}
+
+/**
+ * Picks the blur for a kernel size from settings.cfg: the recursive blur if RECURSIVE_BLUR is set,
+ * otherwise the generic one.
+ *
+ * @param kernel_x kernel width
+ * @param kernel_y kernel height
+ * @return blur function
+ */
+static blur_kernel pick_blur(int kernel_x, int kernel_y) {
+	if (RECURSIVE_BLUR) {
+		return blur_recursive;
+	}
+	return blur_generic;
+}
+
+/**
+ * Picks the adaptive threshold for a block size from settings.cfg: the integral image box mean if
+ * the Tier asks for it, otherwise the generic one.
+ *
+ * @param blocksize adaptive threshold block size
+ * @param box true to use the box mean threshold
+ * @return threshold function
+ */
+static threshold_kernel pick_threshold(int blocksize, bool box) {
+	if (box) {
+		return threshold_box;
+	}
+	return threshold_generic;
+}
+
+/**
+ * Fills KERNELS from the settings.  Must be called once after settings.cfg is loaded and before the
+ * first frame is processed.  Each approximation or replacement kernel which is switched on is then
+ * checked against the exact version with the settings.cfg kernels, and a check out of tolerance
+ * fails the call.
+ *
+ * @param check_all also check the kernels which are switched off (--self-test)
+ * @return status
+ */
+static int select_kernels(bool check_all) {
+	KERNELS.qhe_blur = pick_blur(QHE_GB_KERNEL_X, QHE_GB_KERNEL_Y);
+	KERNELS.t1_threshold = pick_threshold(T1_AT_BLOCKSIZE, T1_AT_BOX);
+	KERNELS.t2_threshold = pick_threshold(T2_AT_BLOCKSIZE, T2_AT_BOX);
+	KERNELS.t3_blur = pick_blur(T3_GB_KERNEL_X, T3_GB_KERNEL_Y);
+	KERNELS.t4_threshold = pick_threshold(T4_AT_BLOCKSIZE, T4_AT_BOX);
+	KERNELS.t4_blur = pick_blur(T4_GB_KERNEL_X, T4_GB_KERNEL_Y);
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Fixed size kernels: QHE blur " << (!RECURSIVE_BLUR && (KERNELS.qhe_blur != blur_generic))
+		<< ", T1 threshold " << (!T1_AT_BOX && (KERNELS.t1_threshold != threshold_generic))
+		<< ", T2 threshold " << (!T2_AT_BOX && (KERNELS.t2_threshold != threshold_generic))
+		<< ", T3 blur " << (!RECURSIVE_BLUR && (KERNELS.t3_blur != blur_generic))
+		<< ", T4 threshold " << (!T4_AT_BOX && (KERNELS.t4_threshold != threshold_generic))
+		<< ", T4 blur " << (!RECURSIVE_BLUR && (KERNELS.t4_blur != blur_generic))
+		<< std::endl
+		<< "Box mean thresholds: T1 " << T1_AT_BOX
+		<< ", T2 " << T2_AT_BOX
+		<< ", T4 " << T4_AT_BOX
+		<< std::endl;
+		LOGGING.close();
+	}
+
+	int status = 0;
+	if (RECURSIVE_BLUR || check_all) {
+		status |= check_recursive_blur("QHE", Size(QHE_GB_KERNEL_X, QHE_GB_KERNEL_Y), QHE_GB_SIGMA_X,
+			QHE_GB_SIGMA_Y);
+		status |= check_recursive_blur("T3", Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y), T3_GB_SIGMA_X,
+			T3_GB_SIGMA_Y);
+		status |= check_recursive_blur("T4", Size(T4_GB_KERNEL_X, T4_GB_KERNEL_Y), T4_GB_SIGMA_X,
+			T4_GB_SIGMA_Y);
+	}
+	if (T3_FIXED_POINT || check_all) {
+		status |= check_fixed_point_tier_three();
+	}
+	return status;
+}
+
 /**
  * Finds the largest contour within the frame after masking.  Called from main thread to prevent waste
  * of CPU time for each tier.
  * 
- * @param in_frame OpenCV matrix image, 16-bit single depth format
+ * @param in_frame OpenCV matrix image, 16-bit single depth format, left unchanged
  * @return bigone vector of cv Points representing the largest frame in the image
  */
-static vector <Point> qhe_bigone(Mat in_frame) {
-	GaussianBlur(in_frame.clone(), in_frame,
+static vector <Point> qhe_bigone(const Mat &in_frame) {
+	TierContext &scratch = SCRATCH;
+	KERNELS.qhe_blur(in_frame, scratch.qhe_blur,
 		Size(QHE_GB_KERNEL_X, QHE_GB_KERNEL_Y),
 		QHE_GB_SIGMA_X,
-		QHE_GB_SIGMA_Y,
-		BORDER_DEFAULT
+		QHE_GB_SIGMA_Y
 	);
-	threshold(in_frame.clone(), in_frame, 1, 255, THRESH_BINARY);
-	vector <vector <Point>> local_contours = contours_only(in_frame);
+	threshold(scratch.qhe_blur, scratch.qhe_mask, 1, 255, THRESH_BINARY);
+	// The halo test measures the distance to every edge point, so none may be dropped
+	ContourSet local_contours = contours_only(scratch.qhe_mask, CHAIN_APPROX_NONE);
 	int largest_contour_index = largest_contour(local_contours);
 	if (largest_contour_index < 0) {
 		vector <Point> empty;
 		empty.push_back(Point(-1, -1));
 		return empty;
 	} else {
-		vector <Point> bigone = local_contours[largest_contour_index];
+		vector <Point> bigone = local_contours.copy(largest_contour_index);
 		return bigone;
 	}
 }
@@ -914,13 +1387,15 @@ static vector <Point> qhe_bigone(Mat in_frame) {
  * `disappear'.  The distance from the moon edge which is to be masked is determined by QHE_WIDTH
  * from settings.cfg.
  *
- * @param contours vector of OpenCV vectors of int-int point contour edges
+ * @param contours ContourSet of the Tier's mask
  * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
- * @return out_contours vector of OpenCV int-int Point vectors representing valid contours
+ * @param offset position of the Tier's mask within the centered frame
+ * @return kept indices into contours of the valid contours, in order
  */
-static vector <vector<Point>> quiet_halo_elim(vector <vector<Point>> contours, vector <Point> bigone) {
+static vector <int> quiet_halo_elim(const ContourSet &contours, const vector <Point> &bigone,
+	Point offset) {
 	float distance;
-	vector <vector<Point>> out_contours;
+	vector <int> kept;
 
 	bool caught_mask = false;
 
@@ -934,21 +1409,91 @@ static vector <vector<Point>> quiet_halo_elim(vector <vector<Point>> contours, v
 		int x_cen = (M.m10/M.m00);
 		int y_cen = (M.m01/M.m00);
 		if ((x_cen < 0) || (y_cen < 0)) {
-			x_cen = contours[i][0].x;
-			y_cen = contours[i][0].y;
+			Point first = contours[i].at<Point>(0);
+			x_cen = first.x;
+			y_cen = first.y;
 		}
 		for (size_t j = 0; j < bigone.size(); j++) {
-			distance = sqrt(pow((x_cen - bigone[j].x), 2) + pow((y_cen - bigone[j].y), 2));
+			Point edge = bigone[j] - offset;
+			distance = sqrt(pow((x_cen - edge.x), 2) + pow((y_cen - edge.y), 2));
 			if (distance < QHE_WIDTH) {
 				caught_mask = true;
 				break;
 			}
 		}
 		if (!caught_mask) {
-			out_contours.push_back(contours[i]);
+			kept.push_back(i);
 		}
 	}
-	return out_contours;
+	return kept;
+}
+
+/**
+ * Cheap pre-stage which decides whether a frame is worth running the Tiers on.  The change energy is
+ * the number of pixels inside the moon disc which changed by more than MOTION_GATE_PIXEL since the
+ * previous centered frame.  The disc is shrunk by QHE_WIDTH so that the wobble of the limb does not
+ * count as change.  A frame is skipped when its energy stays below the noise floor, a running mean
+ * plus MOTION_GATE_K running deviations of the energy.  The floor is learned from the first
+ * MOTION_GATE_WARMUP frames, which are never skipped, and afterwards follows the energy clamped to the
+ * limit, so a passing bird barely raises it.  Every decision is written to gating.csv.
+ *
+ * Must be called in frame order.
+ *
+ * @param framecnt int of nth frame retrieved by program
+ * @param in_frame OpenCV matrix image, centered frame n
+ * @param old_frame OpenCV matrix image, centered frame n-1
+ * @return true if the Tiers should be skipped for this frame
+ */
+static bool motion_gate(int framecnt, Mat in_frame, Mat old_frame) {
+	Mat diff;
+	Mat disc;
+
+	// Only look where both frames show the moon, away from the limb
+	bitwise_and(in_frame > BLACKOUT_THRESH, old_frame > BLACKOUT_THRESH, disc);
+	if (QHE_WIDTH > 1) {
+		erode(disc, disc, getStructuringElement(MORPH_RECT, Size(QHE_WIDTH, QHE_WIDTH)));
+	}
+	absdiff(in_frame, old_frame, diff);
+	int energy = countNonZero((diff > MOTION_GATE_PIXEL) & disc);
+
+	double limit = GATE_FLOOR_MEAN + MOTION_GATE_K * std::max(1.0, std::sqrt(GATE_FLOOR_VAR));
+	bool warming = GATE_FRAMES < MOTION_GATE_WARMUP;
+	bool skip = !warming && (energy <= limit);
+
+	// Update the noise floor.  While warming up this is a plain running mean.
+	double sample = warming ? energy : std::min(static_cast<double>(energy), limit);
+	double alpha = std::max(MOTION_GATE_ALPHA, 1.0 / (GATE_FRAMES + 1));
+	double delta = sample - GATE_FLOOR_MEAN;
+	GATE_FLOOR_MEAN += alpha * delta;
+	GATE_FLOOR_VAR = (1 - alpha) * (GATE_FLOOR_VAR + alpha * delta * delta);
+	GATE_FRAMES++;
+
+	std::ofstream outfile;
+	outfile.open(GATEDATA, std::ios_base::app);
+	outfile
+	<< framecnt
+	<< ","
+	<< energy
+	<< ","
+	<< GATE_FLOOR_MEAN
+	<< ","
+	<< limit
+	<< ","
+	<< skip
+	<< std::endl;
+	outfile.close();
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Motion gate energy " << energy << " against limit " << limit
+		<< (skip ? ", skipping tiers for frame " : ", running tiers for frame ")
+		<< framecnt
+		<< std::endl;
+		LOGGING.close();
+	}
+
+	return skip;
 }
 
 /**
@@ -956,77 +1501,18 @@ static vector <vector<Point>> quiet_halo_elim(vector <vector<Point>> contours, v
  * set in the T1 section of settings.cfg.  Contours are detected based on a relatively strict OpenCV
  * adaptiveThreshold function.  These should be gauranteed "hits".
  *
- * @param framecnt int of nth frame retrieved by program
  * @param in_frame OpenCV matrix image, 16-bit single depth format
- * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
- * @return status
+ * @param old_frame unused by this Tier
+ * @param older_frame unused by this Tier
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
  */
-int tier_one(int framecnt, Mat in_frame, vector <Point> bigone) {
-	Point2f center;
-	float radius;
-	float bigradius = 0;
-	std::ofstream outfile;
-	adaptiveThreshold(in_frame.clone(), in_frame,
+static Mat tier_one(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	KERNELS.t1_threshold(in_frame, SCRATCH.mask,
 		T1_AT_MAX,
-		ADAPTIVE_THRESH_GAUSSIAN_C,
-		THRESH_BINARY_INV,
 		T1_AT_BLOCKSIZE,
 		T1_AT_CONSTANT
 	);
-	// Apply dynamic mask
-	in_frame = apply_dynamic_mask(in_frame.clone(), bigone, T1_DYMASK);
-
-	vector <vector<Point>> contours = contours_only(in_frame);
-	if (contours.size() > 1) {
-		contours = quiet_halo_elim(contours, bigone);
-
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Number of contours in tier 1 pass for frame "
-			<< framecnt
-			<< ": "
-			<< contours.size()
-			<< std::endl;
-			LOGGING.close();
-		}
-		int largest_contour_index = largest_contour(contours);
-		if (largest_contour_index > -1) {
-			minEnclosingCircle(contours[largest_contour_index], center, bigradius);
-		}
-		outfile.open(TIER1FILE, std::ios_base::app);
-		// Cycle through the contours
-		for (auto vec : contours) {
-			// Greater than one includes lunar ellipse
-			if (vec.size() > 1) {
-				minEnclosingCircle(vec, center, radius);
-				if (radius != bigradius) {
-					// Open the outfile to append
-					outfile
-					<< framecnt
-					<< ","
-					<< static_cast<int>(center.x)
-					<< ","
-					<< static_cast<int>(center.y)
-					<< ","
-					<< radius
-					<< std::endl;
-				}
-			}
-		}
-		outfile.close();
-	} else {
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Found too few contours for frame " << framecnt << " Tier "
-			<< "1 "
-			<< "skipping this tier for this frame."
-			<< std::endl;
-			LOGGING.close();
-		}
-	}
-	return 0;
+	return SCRATCH.mask;
 }
 
 /**
@@ -1034,285 +1520,2194 @@ int tier_one(int framecnt, Mat in_frame, vector <Point> bigone) {
  * set in the T2 section of settings.cfg.  Contours are detected based on a relatively loose OpenCV
  * adaptiveThreshold function.
  *
- * @param framecnt int of nth frame retrieved by program
  * @param in_frame OpenCV matrix image, 16-bit single depth format
- * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
- * @return status
+ * @param old_frame unused by this Tier
+ * @param older_frame unused by this Tier
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
  */
-int tier_two(int framecnt, Mat in_frame, vector <Point> bigone) {
-	Point2f center;
-	float radius;
-	float bigradius = 0;
-	std::ofstream outfile;
-	adaptiveThreshold(in_frame.clone(), in_frame,
+static Mat tier_two(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	KERNELS.t2_threshold(in_frame, SCRATCH.mask,
 		T2_AT_MAX,
-		ADAPTIVE_THRESH_GAUSSIAN_C,
-		THRESH_BINARY_INV,
 		T2_AT_BLOCKSIZE,
 		T2_AT_CONSTANT
 	);
-	// Apply dynamic mask
-	in_frame = apply_dynamic_mask(in_frame.clone(), bigone, T2_DYMASK);
-	vector <vector<Point>> contours = contours_only(in_frame);
-	if (contours.size() > 1) {
-		contours = quiet_halo_elim(contours, bigone);
+	return SCRATCH.mask;
+}
 
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Number of contours in tier 2 pass for frame "
-			<< framecnt
-			<< ": "
-			<< contours.size()
-			<< std::endl;
-			LOGGING.close();
-		}
-		int largest_contour_index = largest_contour(contours);
-		if (largest_contour_index > -1) {
-			minEnclosingCircle(contours[largest_contour_index], center, bigradius);
-		}
-		outfile.open(TIER2FILE, std::ios_base::app);
-		// Cycle through the contours
-		for (auto vec : contours) {
-			// Greater than one includes lunar ellipse
-			if (vec.size() > 1) {
-				minEnclosingCircle(vec, center, radius);
-				if (radius != bigradius) {
-					// Open the outfile to append
-					outfile
-					<< framecnt
-					<< ","
-					<< static_cast<int>(center.x)
-					<< ","
-					<< static_cast<int>(center.y)
-					<< ","
-					<< radius
-					<< std::endl;
-				}
-			}
-		}
-		outfile.close();
-	} else {
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Found too few contours for frame " << framecnt << " Tier "
-			<< "2 "
-			<< "skipping this tier for this frame."
-			<< std::endl;
-			LOGGING.close();
+/**
+ * This is the third pass to detect valid contours in a frame.  The parameters of the function are
+ * set in the T3 section of settings.cfg.  The detector performs an isotropic Laplacian on the current
+ * frame and the previous frame (settings.cfg can be modified for anisotropic Laplacian).  The outputs
+ * are blurred and recombined.  Values passing a cutoff threshold are retained and the contours are
+ * detected.
+ *
+ * Given frame n-2 as well (DOUBLE_DIFFERENCE), a pixel must pass the cutoff against both earlier
+ * frames: the larger of their filtered values is subtracted.  Limb shimmer which flickers between
+ * frames rarely passes twice in a row, while a bird entering the pixel does.
+ *
+ * @param in_frame OpenCV matrix image, 16-bit single depth format
+ * @param old_frame OpenCV matrix image, 16-bit single depth format, stored from previous cycle
+ * @param older_frame OpenCV matrix image, frame n-2, or empty to difference two frames only
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
+ */
+static Mat tier_three(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	TierContext &scratch = SCRATCH;
+
+	/* Eli Method for Tier 3 */
+	Laplacian(in_frame, scratch.in_lap, CV_32F,
+		T3_LAP_KERNEL,
+		T3_LAP_SCALE,
+		T3_LAP_DELTA,
+		BORDER_DEFAULT
+	);
+	Laplacian(old_frame, scratch.old_lap, CV_32F,
+		T3_LAP_KERNEL,
+		T3_LAP_SCALE,
+		T3_LAP_DELTA,
+		BORDER_DEFAULT
+	);
+	KERNELS.t3_blur(scratch.in_lap, scratch.in_blur,
+		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+		T3_GB_SIGMA_X,
+		T3_GB_SIGMA_Y
+	);
+	KERNELS.t3_blur(scratch.old_lap, scratch.old_blur,
+		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+		T3_GB_SIGMA_X,
+		T3_GB_SIGMA_Y
+	);
+	if (!older_frame.empty()) {
+		Laplacian(older_frame, scratch.older_lap, CV_32F,
+			T3_LAP_KERNEL,
+			T3_LAP_SCALE,
+			T3_LAP_DELTA,
+			BORDER_DEFAULT
+		);
+		KERNELS.t3_blur(scratch.older_lap, scratch.older_blur,
+			Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+			T3_GB_SIGMA_X,
+			T3_GB_SIGMA_Y
+		);
+		max(scratch.old_blur, scratch.older_blur, scratch.old_blur);
+	}
+	subtract(scratch.in_blur, scratch.old_blur, scratch.diff);
+	compare(scratch.diff, T3_CUTOFF_THRESH, scratch.mask, CMP_GT);
+	/* end Eli Method */
+	return scratch.mask;
+}
+
+/**
+ * Fixed point version of tier_three() for machines with slow float throughput.  The Laplacian is
+ * accumulated straight into 16-bit integers with the scale T3_LAP_SCALE * 2^T3_FIXED_SHIFT, so every
+ * later step (blur, difference, threshold) works on CV_16S instead of CV_32F.  The shift trades range
+ * for resolution: values are kept to 1/2^T3_FIXED_SHIFT, and values past 32767/2^T3_FIXED_SHIFT
+ * saturate.  Only the strongest edges (the limb, which is masked out anyway) reach that.  How far the
+ * mask is from the float version is checked once at startup, see check_fixed_point_tier_three().
+ *
+ * @param in_frame OpenCV matrix image, 16-bit single depth format
+ * @param old_frame OpenCV matrix image, 16-bit single depth format, stored from previous cycle
+ * @param older_frame OpenCV matrix image, frame n-2, or empty to difference two frames only
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
+ */
+static Mat tier_three_fixed(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	TierContext &scratch = SCRATCH;
+	double fixed_scale = static_cast<double>(1 << T3_FIXED_SHIFT);
+
+	Laplacian(in_frame, scratch.fixed_in, CV_16S,
+		T3_LAP_KERNEL,
+		T3_LAP_SCALE * fixed_scale,
+		T3_LAP_DELTA * fixed_scale,
+		BORDER_DEFAULT
+	);
+	Laplacian(old_frame, scratch.fixed_old, CV_16S,
+		T3_LAP_KERNEL,
+		T3_LAP_SCALE * fixed_scale,
+		T3_LAP_DELTA * fixed_scale,
+		BORDER_DEFAULT
+	);
+	KERNELS.t3_blur(scratch.fixed_in, scratch.fixed_in_blur,
+		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+		T3_GB_SIGMA_X,
+		T3_GB_SIGMA_Y
+	);
+	KERNELS.t3_blur(scratch.fixed_old, scratch.fixed_old_blur,
+		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+		T3_GB_SIGMA_X,
+		T3_GB_SIGMA_Y
+	);
+	if (!older_frame.empty()) {
+		Laplacian(older_frame, scratch.fixed_older, CV_16S,
+			T3_LAP_KERNEL,
+			T3_LAP_SCALE * fixed_scale,
+			T3_LAP_DELTA * fixed_scale,
+			BORDER_DEFAULT
+		);
+		KERNELS.t3_blur(scratch.fixed_older, scratch.fixed_older_blur,
+			Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
+			T3_GB_SIGMA_X,
+			T3_GB_SIGMA_Y
+		);
+		max(scratch.fixed_old_blur, scratch.fixed_older_blur, scratch.fixed_old_blur);
+	}
+	subtract(scratch.fixed_in_blur, scratch.fixed_old_blur, scratch.fixed_diff, noArray(), CV_16S);
+	compare(scratch.fixed_diff, T3_CUTOFF_THRESH * fixed_scale, scratch.fixed_mask, CMP_GT);
+	return scratch.fixed_mask;
+}
+
+/**
+ * Checks tier_three_fixed() against tier_three() on three test frames of a textured disc with a dark
+ * blob crossing it.  Fails when the masks differ in more than T3_FIXED_TOLERANCE times the number of
+ * pixels set in the float mask.
+ *
+ * @return status
+ */
+static int check_fixed_point_tier_three() {
+	Mat test_frames[3];
+	for (int t = 0; t < 3; t++) {
+		test_frames[t] = Mat::zeros(256, 256, CV_8UC1);
+		for (int y = 0; y < test_frames[t].rows; y++) {
+			uchar *pixel = test_frames[t].ptr<uchar>(y);
+			for (int x = 0; x < test_frames[t].cols; x++) {
+				if ((x - 128) * (x - 128) + (y - 128) * (y - 128) <= 100 * 100) {
+					pixel[x] = saturate_cast<uchar>(150 + (x * 7 + y * 13 + t * 29) % 32);
+				}
+			}
+		}
+		ellipse(test_frames[t], Point(60 + 12 * t, 110 + 3 * t), Size(9, 4), 20, 0, 360, Scalar(25), FILLED);
+	}
+	// The two chains keep their masks in different SCRATCH buffers
+	Mat float_mask = tier_three(test_frames[2], test_frames[1], test_frames[0]);
+	Mat fixed_mask = tier_three_fixed(test_frames[2], test_frames[1], test_frames[0]);
+	Mat mismatch;
+	compare(float_mask, fixed_mask, mismatch, CMP_NE);
+	int mismatched = countNonZero(mismatch);
+	int float_pixels = countNonZero(float_mask);
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Fixed point Tier 3 check: " << mismatched << " pixels differ, "
+		<< float_pixels << " set in the float mask"
+		<< std::endl;
+		LOGGING.close();
+	}
+	if (mismatched > T3_FIXED_TOLERANCE * std::max(float_pixels, 1)) {
+		std::cerr
+		<< "WARNING: Fixed point Tier 3 differs from float in " << mismatched << " pixels, more than "
+		<< "T3_FIXED_TOLERANCE allows for a mask of " << float_pixels << " pixels"
+		<< std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * This is the fourth pass to detect valid contours in a frame.  The parameters of the function are
+ * set in the T4 section of settings.cfg.  This is the UnCanny method for detecting motion.  The steps
+ * are essentially the backward operation of the steps taken during Canny filtering.  The current
+ * frame is subtracted from the previous frame, and this output is threholded.  The thresholded image
+ * is then passed through directional Sobel filters to separate the x and y components.  These
+ * components are squared, added to each other, and square rooted.  The output is rescaled to match
+ * the input value ranges, and a Gaussian blur is applied.  Since this output is messy, the blurry
+ * image is processed using Zhang-Suen thinning to get distinct edges.  Any details lost between the
+ * blurring and thinning steps reduce noise.  Contours are then detected in the normal way.
+ *
+ * @param in_frame OpenCV matrix image, 16-bit single depth format
+ * @param old_frame OpenCV matrix image, 16-bit single depth format, stored from previous cycle
+ * @param older_frame OpenCV matrix image, frame n-2, or empty to difference two frames only.  When
+ * given, the brighter of frames n-1 and n-2 is subtracted, so a pixel must have changed against both.
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
+ */
+static Mat tier_four(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	TierContext &scratch = SCRATCH;
+
+	/* UnCanny v2 */
+
+	if (!older_frame.empty()) {
+		max(old_frame, older_frame, scratch.diff);
+		subtract(in_frame, scratch.diff, scratch.diff);
+	} else {
+		subtract(in_frame, old_frame, scratch.diff);
+	}
+	KERNELS.t4_threshold(scratch.diff, scratch.mask,
+		T4_AT_MAX,
+		T4_AT_BLOCKSIZE,
+		T4_AT_CONSTANT
+	);
+	Sobel(scratch.mask, scratch.grad_x, CV_32F, 1, 0);
+	Sobel(scratch.mask, scratch.grad_y, CV_32F, 0, 1);
+	if (T4_POWER == 2) {
+		// pow, add and sqrt in a single pass
+		magnitude(scratch.grad_x, scratch.grad_y, scratch.grad_x);
+	} else {
+		pow(scratch.grad_x, T4_POWER, scratch.grad_x);
+		pow(scratch.grad_y, T4_POWER, scratch.grad_y);
+		add(scratch.grad_x, scratch.grad_y, scratch.grad_x);
+		sqrt(scratch.grad_x, scratch.grad_x);
+	}
+	convertScaleAbs(scratch.grad_x, scratch.edges);
+	KERNELS.t4_blur(scratch.edges, scratch.edges_blur,
+		Size(T4_GB_KERNEL_X, T4_GB_KERNEL_Y),
+		T4_GB_SIGMA_X,
+		T4_GB_SIGMA_Y
+	);
+	ximgproc::thinning(scratch.edges_blur, scratch.mask, T4_THINNING);
+	
+	/* end UnCanny v2 */
+
+	return scratch.mask;
+}
+
+/**
+ * Number of pixels around a region which a Tier's filter chain reads from.  Running Tiers 1 to 3 on a
+ * region grown by this margin gives the same mask inside the region as running them on the whole
+ * frame.  Tier 4 is not local: thinning peels a blob from its edges, so cutting a blob at a region
+ * border can move its skeleton further than any fixed margin.  run_tier() therefore always runs
+ * Tier 4 on the whole moon, and its margin only keeps the border of that area clean.
+ *
+ * @param tier Tier number, 1 to 4
+ * @return margin in pixels
+ */
+static int tier_margin(int tier) {
+	switch (tier) {
+		case 1:
+			return T1_AT_BLOCKSIZE/2;
+		case 2:
+			return T2_AT_BLOCKSIZE/2;
+		case 3:
+			return T3_LAP_KERNEL/2 + std::max(T3_GB_KERNEL_X, T3_GB_KERNEL_Y)/2;
+		case 4:
+			// Sobel reads one pixel, and thinning may creep a couple of pixels further
+			return T4_AT_BLOCKSIZE/2 + 1 + std::max(T4_GB_KERNEL_X, T4_GB_KERNEL_Y)/2 + 2;
+	}
+	return 0;
+}
+
+/**
+ * Finds the part of the centered frame the Tiers need to look at: the bounding rectangle of the moon
+ * edge.  Everything outside it is sky which the dynamic mask and halo elimination throw away.  Falls
+ * back to the whole frame if the moon edge was not found.
+ *
+ * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
+ * @param size size of the centered frame
+ * @return area OpenCV Rect of the frame to process
+ */
+static Rect moon_rect(const vector <Point> &bigone, Size size) {
+	Rect image_rect = Rect({}, size);
+	Rect area = boundingRect(bigone) & image_rect;
+	if (area.area() < 2) {
+		return image_rect;
+	}
+	return area;
+}
+
+/**
+ * Runs a Tier's filter chain only on a list of regions of the frame and merges the results into one
+ * mask covering area.  Each region is grown by margin pixels before filtering, and only the region
+ * itself is copied back, so every pixel of the merged mask matches the whole frame result.  Pixels
+ * outside every region are left at zero.
+ *
+ * The chains are handed views into the frames.  OpenCV filters read the real pixels past the edge of
+ * a view where a copy would be padded, but only within margin of it, so the region comes out the same
+ * either way.  The frames themselves must not be views, or the filters read past the frame edge.
+ *
+ * @param in_frame OpenCV matrix image, centered frame n
+ * @param old_frame OpenCV matrix image, centered frame n-1, or empty if the chain does not use it
+ * @param older_frame OpenCV matrix image, centered frame n-2, or empty if the chain does not use it
+ * @param area OpenCV Rect of the frame covered by the mask, see moon_rect()
+ * @param regions vector of OpenCV Rect to filter, in frame coordinates
+ * @param margin pixels read by the filter chain around each output pixel, see tier_margin()
+ * @param chain Tier filter chain, one of tier_one() to tier_four()
+ * @return mask binary mask of the candidate silhouettes, the size of area
+ */
+static Mat region_mask(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame, Rect area,
+	vector <Rect> regions, int margin, tier_chain chain) {
+	Mat mask = Mat::zeros(area.size(), CV_8UC1);
+	Rect image_rect = Rect({}, in_frame.size());
+	for (auto region : regions) {
+		region &= area;
+		if (region.empty()) {
+			continue;
+		}
+		Rect grown = Rect(region.x - margin, region.y - margin,
+			region.width + 2*margin, region.height + 2*margin) & image_rect;
+		// The chains never write to their inputs, so they are handed views into the frames
+		Mat local_old;
+		if (!old_frame.empty()) {
+			local_old = old_frame(grown);
+		}
+		Mat local_older;
+		if (!older_frame.empty()) {
+			local_older = older_frame(grown);
+		}
+		Mat local_mask = chain(in_frame(grown), local_old, local_older);
+		local_mask(region - grown.tl()).copyTo(mask(region - area.tl()));
+	}
+	return mask;
+}
+
+/**
+ * Per frame work budget of the Tiers.  A Tier's mask is saturated when more than SATURATION_FILL of
+ * it is set, or when it holds more than MAX_CONTOURS contours or blobs.  Such a frame (clouds, haze)
+ * would take seconds to turn into thousands of junk rows, so the Tier stops and only a summary of
+ * the frame is kept for saturated.csv.
+ *
+ * @param framecnt int of nth frame retrieved by program
+ * @param tier Tier number, used in the log
+ * @param blobs number of contours or blobs, 0 if not labeled yet
+ * @param fill fraction of the mask which is set
+ * @param saturation receives the summary if the mask is saturated
+ * @return true if the Tier should stop on this frame
+ */
+static bool saturated(int framecnt, int tier, size_t blobs, double fill, Saturation &saturation) {
+	bool over_fill = (SATURATION_FILL > 0) && (fill > SATURATION_FILL);
+	bool over_count = (MAX_CONTOURS > 0) && (blobs > static_cast<size_t>(MAX_CONTOURS));
+	if (!over_fill && !over_count) {
+		return false;
+	}
+	saturation.blobs = blobs;
+	saturation.fill = fill;
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Tier " << tier << " saturated on frame " << framecnt << " with " << blobs << " contours and "
+		<< fill << " of the mask set, skipping this tier for this frame."
+		<< std::endl;
+		LOGGING.close();
+	}
+	return true;
+}
+
+/**
+ * Tells whether a blob of a Tier mask is the lunar ellipse rather than a silhouette.  The ellipse is
+ * the one shape reaching around the whole moon: grown by the dynamic mask and QHE_WIDTH, its bounds
+ * cover the bounds of bigone.  The largest shape is not used for this, because a mask filtered only on
+ * some regions of the moon (dirty tiles, cascade boxes) has no ellipse, and its largest shape is
+ * usually the bird.  tier_contours() keeps the older largest contour rule.
+ *
+ * @param bounds bounding box of the blob, in mask coordinates
+ * @param moon bounding box of bigone in mask coordinates, empty if the moon edge was not found
+ * @param maskwidth width of the dynamic mask for this Tier
+ * @return true if the shape is the lunar ellipse
+ */
+static bool lunar_ellipse(Rect bounds, Rect moon, int maskwidth) {
+	if (moon.empty()) {
+		return false;
+	}
+	int slack = maskwidth + QHE_WIDTH;
+	Rect grown(bounds.x - slack, bounds.y - slack, bounds.width + 2*slack, bounds.height + 2*slack);
+	return (grown & moon) == moon;
+}
+
+/**
+ * Bounding box of bigone in the coordinates of a Tier mask.
+ *
+ * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
+ * @param offset position of the mask within the centered frame
+ * @return moon OpenCV Rect, empty if the moon edge was not found
+ */
+static Rect moon_bounds(const vector <Point> &bigone, Point offset) {
+	Rect moon = boundingRect(bigone);
+	if (moon.area() < 2) {
+		return Rect();
+	}
+	return moon - offset;
+}
+
+/**
+ * Turns the binary mask from a Tier's filter chain into rows.  The edge of the moon is masked out,
+ * contours near the halo are dropped by quiet_halo_elim(), and every remaining contour is stored with
+ * its minimum enclosing circle, except those whose radius equals that of the largest one, which is
+ * taken for the lunar ellipse.  This is the rule of earlier releases, kept for CONTOUR_TIERS.  A
+ * saturated mask (see saturated()) stops before the contours are found, or before they are filtered.
+ * The fill is measured after the dynamic mask, so the bright band along the moon edge does not count.
+ *
+ * @param framecnt int of nth frame retrieved by program
+ * @param tier Tier number, used in the log
+ * @param in_frame binary mask from the Tier's filter chain, the dynamic mask is drawn into it
+ * @param offset position of in_frame within the centered frame
+ * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
+ * @param maskwidth width of the dynamic mask for this Tier
+ * @param rows vector of TierRow which receives the silhouettes detected in this frame
+ * @param saturation receives the summary of the frame if the mask is saturated
+ * @return status
+ */
+static int tier_contours(int framecnt, int tier, Mat in_frame, Point offset,
+	const vector <Point> &bigone, int maskwidth, vector <TierRow> &rows, Saturation &saturation) {
+	Point2f center;
+	float radius;
+	float bigradius = 0;
+
+	// Apply dynamic mask
+	in_frame = apply_dynamic_mask(in_frame, bigone, maskwidth, offset);
+	double fill = static_cast<double>(countNonZero(in_frame)) / std::max<size_t>(1, in_frame.total());
+	if (saturated(framecnt, tier, 0, fill, saturation)) {
+		return 0;
+	}
+	ContourSet contours = contours_only(in_frame, CHAIN_APPROX_SIMPLE);
+	if (saturated(framecnt, tier, contours.size(), fill, saturation)) {
+		return 0;
+	}
+	vector <int> kept = quiet_halo_elim(contours, bigone, offset);
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Number of contours in tier " << tier << " pass for frame "
+		<< framecnt
+		<< ": "
+		<< kept.size()
+		<< std::endl;
+		LOGGING.close();
+	}
+	int largest_contour_index = -1;
+	int largest_area = 0;
+	for (auto i : kept) {
+		double area = contourArea(contours[i]);
+		if (area > largest_area) {
+			largest_area = area;
+			largest_contour_index = i;
+		}
+	}
+	if (largest_contour_index > -1) {
+		minEnclosingCircle(contours[largest_contour_index], center, bigradius);
+	}
+	size_t found = rows.size();
+	// Cycle through the contours
+	for (auto i : kept) {
+		// Greater than one includes lunar ellipse
+		if (contours.count(i) < 2) {
+			continue;
+		}
+		minEnclosingCircle(contours[i], center, radius);
+		if (radius == bigradius) {
+			continue;
+		}
+		// Store the row for the write task
+		rows.push_back({framecnt, static_cast<int>(center.x) + offset.x,
+			static_cast<int>(center.y) + offset.y, radius});
+	}
+	if ((rows.size() == found) && DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Found too few contours for frame " << framecnt << " Tier "
+		<< tier << " "
+		<< "skipping this tier for this frame."
+		<< std::endl;
+		LOGGING.close();
+	}
+	return 0;
+}
+
+/**
+ * Turns the binary mask from a Tier's filter chain into rows using one connected components pass
+ * instead of per contour point lists.  Each blob's centroid, area and bounding box come from the
+ * labeling.  Blobs whose centroid lies within QHE_WIDTH of the moon edge are dropped, as in
+ * quiet_halo_elim(), and the lunar ellipse (see lunar_ellipse()) is skipped.  The radius is that of
+ * the circle with the blob's area, sqrt(area / pi).  A saturated mask (see saturated()) stops before
+ * the labeling, or before any row is made.  The fill is measured after the dynamic mask, as in
+ * tier_contours().
+ *
+ * @param framecnt int of nth frame retrieved by program
+ * @param tier Tier number, used in the log
+ * @param in_frame binary mask from the Tier's filter chain, the dynamic mask is drawn into it
+ * @param offset position of in_frame within the centered frame
+ * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
+ * @param maskwidth width of the dynamic mask for this Tier
+ * @param rows vector of TierRow which receives the silhouettes detected in this frame
+ * @param saturation receives the summary of the frame if the mask is saturated
+ * @return status
+ */
+static int tier_blobs(int framecnt, int tier, Mat in_frame, Point offset, const vector <Point> &bigone,
+	int maskwidth, vector <TierRow> &rows, Saturation &saturation) {
+	Rect moon = moon_bounds(bigone, offset);
+	// Apply dynamic mask
+	in_frame = apply_dynamic_mask(in_frame, bigone, maskwidth, offset);
+	double fill = countNonZero(in_frame) / std::max<double>(1, in_frame.total());
+	if (saturated(framecnt, tier, 0, fill, saturation)) {
+		return 0;
+	}
+	Mat labels, stats, centroids;
+	int count = connectedComponentsWithStats(in_frame, labels, stats, centroids, 8, CV_32S);
+	// Label 0 is the background
+	if (saturated(framecnt, tier, count - 1, fill, saturation)) {
+		return 0;
+	}
+
+	// Pixels within QHE_WIDTH of the moon edge, drawn shifted into the coordinates of in_frame
+	vector <Mat> edge(1, Mat(bigone));
+	Mat halo = Mat::zeros(in_frame.size(), CV_8UC1);
+	drawContours(halo, edge, 0, 255, 2*QHE_WIDTH, LINE_8, noArray(), INT_MAX, -offset);
+
+	vector <int> kept;
+	for (int i = 1; i < count; i++) {
+		int x_cen = static_cast<int>(centroids.at<double>(i, 0));
+		int y_cen = static_cast<int>(centroids.at<double>(i, 1));
+		if (halo.at<uchar>(y_cen, x_cen) != 0) {
+			continue;
+		}
+		kept.push_back(i);
+	}
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Number of contours in tier " << tier << " pass for frame "
+		<< framecnt
+		<< ": "
+		<< kept.size()
+		<< std::endl;
+		LOGGING.close();
+	}
+	size_t found = rows.size();
+	for (auto i : kept) {
+		// Single pixels and the lunar ellipse are not silhouettes
+		int area = stats.at<int>(i, CC_STAT_AREA);
+		Rect bounds(stats.at<int>(i, CC_STAT_LEFT), stats.at<int>(i, CC_STAT_TOP),
+			stats.at<int>(i, CC_STAT_WIDTH), stats.at<int>(i, CC_STAT_HEIGHT));
+		if ((area < 2) || lunar_ellipse(bounds, moon, maskwidth)) {
+			continue;
+		}
+		float radius = static_cast<float>(sqrt(area / CV_PI));
+		rows.push_back({framecnt, static_cast<int>(centroids.at<double>(i, 0)) + offset.x,
+			static_cast<int>(centroids.at<double>(i, 1)) + offset.y, radius});
+	}
+	if ((rows.size() == found) && DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Found too few contours for frame " << framecnt << " Tier "
+		<< tier << " "
+		<< "skipping this tier for this frame."
+		<< std::endl;
+		LOGGING.close();
+	}
+	return 0;
+}
+
+/**
+ * Runs one Tier on a frame: the Tier's filter chain over the frame's regions inside the moon, then
+ * blob detection on the merged mask (or contour detection if CONTOUR_TIERS is set).  The rows go to
+ * the Tier's slot in the FrameJob.
+ *
+ * @param tier Tier number, 1 to 4
+ * @param job FrameJob holding the centered frames, bigone and the regions to process
+ * @return status
+ */
+static int run_tier(int tier, FrameJob &job) {
+	tier_chain chain;
+	int maskwidth;
+	switch (tier) {
+		case 1:
+			chain = tier_one;
+			maskwidth = T1_DYMASK;
+			break;
+		case 2:
+			chain = tier_two;
+			maskwidth = T2_DYMASK;
+			break;
+		case 3:
+			chain = T3_FIXED_POINT ? tier_three_fixed : tier_three;
+			maskwidth = T3_DYMASK;
+			break;
+		case 4:
+			chain = tier_four;
+			maskwidth = T4_DYMASK;
+			break;
+		default:
+			return 1;
+	}
+	// Tiers 1 and 2 only look at the current frame
+	Mat old_frame = (tier > 2) ? job.old_frame : Mat();
+	Mat older_frame = ((tier > 2) && DOUBLE_DIFFERENCE) ? job.older_frame : Mat();
+	Rect area = moon_rect(job.bigone, job.frame.size());
+	// Thinning is not local, so Tier 4 always runs on the whole moon in one piece (see tier_margin())
+	vector <Rect> regions = (tier == 4) ? vector <Rect>(1, area) : job.regions;
+	Mat mask = region_mask(job.frame, old_frame, older_frame, area, regions, tier_margin(tier), chain);
+	if (CONTOUR_TIERS) {
+		return tier_contours(job.framecnt, tier, mask, area.tl(), job.bigone, maskwidth,
+			job.tier_rows[tier - 1], job.saturation[tier - 1]);
+	}
+	return tier_blobs(job.framecnt, tier, mask, area.tl(), job.bigone, maskwidth,
+		job.tier_rows[tier - 1], job.saturation[tier - 1]);
+}
+
+/**
+ * Creates an empty history.
+ *
+ * @param depth number of frames kept, at least 1
+ */
+FrameHistory::FrameHistory(size_t depth) : frames(std::max<size_t>(depth, 1)), newest(0), count(0) {
+}
+
+/**
+ * Adds the newest frame, dropping the oldest one if the history is full.  Only the reference is
+ * stored, no pixels are copied.
+ *
+ * @param frame OpenCV matrix image, centered frame
+ */
+void FrameHistory::push(Mat frame) {
+	newest = (newest + 1) % frames.size();
+	frames[newest] = frame;
+	count = std::min(count + 1, frames.size());
+}
+
+/**
+ * Looks a frame up by age.
+ *
+ * @param age 0 for the newest frame, 1 for the one before, and so on
+ * @return the frame, or an empty Mat if the history does not reach that far back
+ */
+Mat FrameHistory::back(size_t age) const {
+	if (age >= count) {
+		return Mat();
+	}
+	return frames[(newest + frames.size() - age) % frames.size()];
+}
+
+/**
+ * Forgets every frame, for when the next frame does not follow on from them.
+ */
+void FrameHistory::clear() {
+	for (auto &frame : frames) {
+		frame.release();
+	}
+	count = 0;
+}
+
+/**
+ * Creates an empty background model.  The first frame passed to apply() starts it.
+ */
+BackgroundModel::BackgroundModel() : frames(0) {
+}
+
+/**
+ * Compares a frame with the background and then folds the frame into the background.  Each pixel
+ * keeps a running Gaussian: a mean and variance which follow the video at rate T5_ALPHA, so the model
+ * costs the same every frame no matter how long it has been running.  Pixels further than T5_K
+ * standard deviations from their mean are foreground.  The standard deviation is floored at
+ * T5_MIN_SIGMA so that perfectly still pixels do not turn every bit of noise into foreground.
+ *
+ * Must be called in frame order.
+ *
+ * @param in_frame OpenCV matrix image, centered frame n
+ * @return foreground binary mask, empty while the model is still warming up
+ */
+Mat BackgroundModel::apply(Mat in_frame) {
+	Mat current;
+	in_frame.convertTo(current, CV_32F);
+	if ((frames == 0) || (mean.size() != current.size())) {
+		mean = current.clone();
+		variance = Mat(current.size(), CV_32F, Scalar(T5_MIN_SIGMA * T5_MIN_SIGMA));
+		frames = 1;
+		return Mat();
+	}
+
+	Mat diff = current - mean;
+	Mat sigma;
+	sqrt(variance, sigma);
+	sigma = max(sigma, T5_MIN_SIGMA);
+	Mat limit = sigma * T5_K;
+	Mat distance = abs(diff);
+	Mat foreground;
+	compare(distance, limit, foreground, CMP_GT);
+
+	// Fold this frame into the model, faster at the start so the model settles quickly
+	double alpha = std::max(T5_ALPHA, 1.0 / (frames + 1));
+	accumulateWeighted(current, mean, alpha);
+	Mat square;
+	multiply(diff, diff, square);
+	accumulateWeighted(square, variance, alpha);
+	frames++;
+
+	if (frames <= T5_WARMUP) {
+		return Mat();
+	}
+	return foreground;
+}
+
+/**
+ * This is the fifth pass to detect valid contours in a frame.  The parameters of the function are
+ * set in the T5 section of settings.cfg.  Instead of comparing two frames like Tiers 3 and 4, the
+ * frame is compared with a background model built from all earlier frames (see BackgroundModel), so
+ * shimmer along the limb which comes and goes is learned as background.  The model must see the
+ * frames in order, so this runs in the ordered commit step rather than as a parallel Tier task.
+ * Frames skipped by the motion gate still update the model but are not searched.
+ *
+ * @param job FrameJob holding the centered frame and bigone
+ * @return status
+ */
+static int tier_five(FrameJob &job) {
+	Mat foreground = BACKGROUND.apply(job.frame);
+	if (foreground.empty() || job.skip_tiers) {
+		return 0;
+	}
+	Rect area = moon_rect(job.bigone, job.frame.size());
+	if (CONTOUR_TIERS) {
+		return tier_contours(job.framecnt, 5, foreground(area), area.tl(), job.bigone, T5_DYMASK,
+			job.tier_rows[4], job.saturation[4]);
+	}
+	return tier_blobs(job.framecnt, 5, foreground(area), area.tl(), job.bigone, T5_DYMASK,
+		job.tier_rows[4], job.saturation[4]);
+}
+
+/**
+ * Builds the list of regions where the Tiers should run.  With DIRTY_TILES off this is the whole
+ * frame.  Otherwise the frame is split into TILE_SIZE tiles, and a tile is dirty if at least
+ * TILE_MIN_PIXELS pixels inside the moon changed by more than TILE_PIXEL since the previous centered
+ * frame.  Neighbouring dirty tiles are merged, and the bounding rectangle of each group is a region.
+ *
+ * @param in_frame OpenCV matrix image, centered frame n
+ * @param old_frame OpenCV matrix image, centered frame n-1
+ * @return regions vector of OpenCV Rect where the Tiers should run
+ */
+static vector <Rect> dirty_regions(Mat in_frame, Mat old_frame) {
+	vector <Rect> regions;
+	if (!DIRTY_TILES || (TILE_SIZE < 1) || old_frame.empty()) {
+		regions.push_back(Rect({}, in_frame.size()));
+		return regions;
+	}
+
+	// Pixels on the moon which changed
+	Mat diff;
+	absdiff(in_frame, old_frame, diff);
+	Mat changed = (diff > TILE_PIXEL) & (in_frame > BLACKOUT_THRESH) & (old_frame > BLACKOUT_THRESH);
+
+	// Count the changed pixels of every tile, including the partial tiles at the edges
+	int tiles_x = (in_frame.cols + TILE_SIZE - 1) / TILE_SIZE;
+	int tiles_y = (in_frame.rows + TILE_SIZE - 1) / TILE_SIZE;
+	Mat tilemap = Mat::zeros(Size(tiles_x, tiles_y), CV_8UC1);
+	for (int ty = 0; ty < tiles_y; ty++) {
+		for (int tx = 0; tx < tiles_x; tx++) {
+			Rect tile = Rect(tx*TILE_SIZE, ty*TILE_SIZE, TILE_SIZE, TILE_SIZE) & Rect({}, in_frame.size());
+			if (countNonZero(changed(tile)) >= TILE_MIN_PIXELS) {
+				tilemap.at<uchar>(ty, tx) = 255;
+			}
+		}
+	}
+
+	// Merge touching dirty tiles into regions
+	Mat labels, stats, centroids;
+	int count = connectedComponentsWithStats(tilemap, labels, stats, centroids, 8, CV_32S);
+	for (int i = 1; i < count; i++) {
+		Rect region = Rect(
+			stats.at<int>(i, CC_STAT_LEFT) * TILE_SIZE,
+			stats.at<int>(i, CC_STAT_TOP) * TILE_SIZE,
+			stats.at<int>(i, CC_STAT_WIDTH) * TILE_SIZE,
+			stats.at<int>(i, CC_STAT_HEIGHT) * TILE_SIZE
+		) & Rect({}, in_frame.size());
+		regions.push_back(region);
+	}
+
+	if (DEBUG_COUT) {
+		int area = 0;
+		for (auto region : regions) {
+			area += region.area();
+		}
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Dirty tiles cover " << regions.size() << " regions with " << area << " of "
+		<< in_frame.total() << " pixels"
+		<< std::endl;
+		LOGGING.close();
+	}
+	return regions;
+}
+
+/**
+ * Index of the TaskPool worker running on this thread, or -1 for threads outside the pool.
+ */
+thread_local int WORKER_INDEX = -1;
+
+/**
+ * Starts the worker threads of the pool.
+ *
+ * @param workers number of worker threads.  Values below one use one thread per CPU core.
+ */
+TaskPool::TaskPool(int workers) : queued(0), next_queue(0), stopping(false) {
+	if (workers < 1) {
+		workers = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+	}
+	for (int i = 0; i < workers; i++) {
+		queues.push_back(std::unique_ptr<WorkQueue>(new WorkQueue));
+	}
+	for (int i = 0; i < workers; i++) {
+		threads.push_back(std::thread(&TaskPool::worker_loop, this, i));
+	}
+}
+
+/**
+ * Stops the worker threads.  Every submitted task must have finished before the pool is destroyed.
+ */
+TaskPool::~TaskPool() {
+	{
+		std::lock_guard<std::mutex> guard(idle_lock);
+		stopping = true;
+	}
+	idle_cv.notify_all();
+	for (auto &worker : threads) {
+		worker.join();
+	}
+}
+
+/**
+ * Queues a task.  Tasks submitted by a worker go to that worker's own deque so that the task which
+ * just became ready runs on the core which already holds its data.  Tasks from outside the pool are
+ * spread over the deques round robin.
+ *
+ * @param task function to run on one of the worker threads
+ */
+void TaskPool::submit(std::function<void()> task) {
+	int index = WORKER_INDEX;
+	if (index < 0) {
+		index = next_queue++ % queues.size();
+	}
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		queues[index]->tasks.push_back(std::move(task));
+	}
+	{
+		std::lock_guard<std::mutex> guard(idle_lock);
+		queued++;
+	}
+	idle_cv.notify_one();
+}
+
+/**
+ * @return number of worker threads in the pool
+ */
+int TaskPool::size() const {
+	return threads.size();
+}
+
+/**
+ * Fetches the next task for a worker.  The worker's own deque is popped from the back, and when it
+ * is empty the other deques are stolen from at the front.
+ *
+ * @param index index of the worker looking for a task
+ * @param task holder for the task which was found
+ * @return true if a task was found
+ */
+bool TaskPool::take_task(int index, std::function<void()> &task) {
+	{
+		std::lock_guard<std::mutex> guard(queues[index]->lock);
+		if (!queues[index]->tasks.empty()) {
+			task = std::move(queues[index]->tasks.back());
+			queues[index]->tasks.pop_back();
+			return true;
+		}
+	}
+	for (size_t i = 1; i < queues.size(); i++) {
+		WorkQueue &victim = *queues[(index + i) % queues.size()];
+		std::lock_guard<std::mutex> guard(victim.lock);
+		if (!victim.tasks.empty()) {
+			task = std::move(victim.tasks.front());
+			victim.tasks.pop_front();
+			return true;
+		}
+	}
+	return false;
+}
+
+/**
+ * Main loop of each worker thread.  Runs tasks until the pool is stopped, sleeping while there is
+ * nothing queued anywhere.
+ *
+ * @param index index of this worker
+ */
+void TaskPool::worker_loop(int index) {
+	WORKER_INDEX = index;
+	std::function<void()> task;
+	while (true) {
+		// Claim one of the queued tasks, or leave once the pool is stopped and drained
+		{
+			std::unique_lock<std::mutex> guard(idle_lock);
+			idle_cv.wait(guard, [this] { return stopping || queued > 0; });
+			if (queued == 0) {
+				return;
+			}
+			queued--;
+		}
+		// The claimed task is in one of the deques, though another worker may be taking its neighbour
+		while (!take_task(index, task)) {
+			std::this_thread::yield();
+		}
+		task();
+		task = nullptr;
+	}
+}
+
+/**
+ * Creates an empty graph.
+ */
+TaskGraph::TaskGraph() : remaining(0) {
+}
+
+/**
+ * Adds a task to the graph.  Must not be called after launch().
+ *
+ * @param work function to run once all of the task's dependencies are done
+ * @return index of the new task, used with add_edge()
+ */
+int TaskGraph::add_task(std::function<void()> work) {
+	nodes.emplace_back();
+	nodes.back().work = std::move(work);
+	nodes.back().pending = 0;
+	remaining++;
+	return nodes.size() - 1;
+}
+
+/**
+ * Makes one task wait for another.  Must not be called after launch().
+ *
+ * @param before index of the task which must finish first
+ * @param after index of the task which depends on it
+ */
+void TaskGraph::add_edge(int before, int after) {
+	nodes[before].successors.push_back(after);
+	nodes[after].pending++;
+}
+
+/**
+ * Submits every task without dependencies to the pool.  The rest follow as they become ready.
+ *
+ * @param pool TaskPool which runs the tasks
+ */
+void TaskGraph::launch(TaskPool &pool) {
+	vector <int> ready;
+	for (size_t i = 0; i < nodes.size(); i++) {
+		if (nodes[i].pending == 0) {
+			ready.push_back(i);
+		}
+	}
+	auto self = shared_from_this();
+	for (auto i : ready) {
+		pool.submit([self, &pool, i] { self->run_task(pool, i); });
+	}
+}
+
+/**
+ * Blocks the calling thread until every task in the graph has run.
+ */
+void TaskGraph::wait() {
+	std::unique_lock<std::mutex> guard(done_lock);
+	done_cv.wait(guard, [this] { return remaining == 0; });
+}
+
+/**
+ * Runs a single task and releases the tasks which were waiting on it.  An exception thrown by a task
+ * is reported and does not stop the rest of the graph.
+ *
+ * @param pool TaskPool which runs the tasks
+ * @param index index of the task to run
+ */
+void TaskGraph::run_task(TaskPool &pool, int index) {
+	try {
+		nodes[index].work();
+	} catch (const std::exception &e) {
+		std::cerr << "WARNING: A frame task failed with error: " << e.what() << std::endl;
+	}
+	auto self = shared_from_this();
+	for (auto next : nodes[index].successors) {
+		if (--nodes[next].pending == 0) {
+			pool.submit([self, &pool, next] { self->run_task(pool, next); });
+		}
+	}
+	std::lock_guard<std::mutex> guard(done_lock);
+	if (--remaining == 0) {
+		done_cv.notify_all();
+	}
+}
+
+/**
+ * Appends the rows found by a Tier to its csv file.
+ *
+ * @param tierfile location of the Tier csv file
+ * @param rows vector of TierRow to write
+ * @return status
+ */
+static int write_tier_rows(std::string tierfile, const vector <TierRow> &rows) {
+	if (rows.empty()) {
+		return 0;
+	}
+	std::ofstream outfile;
+	outfile.open(tierfile, std::ios_base::app);
+	for (auto &row : rows) {
+		outfile
+		<< row.framecnt
+		<< ","
+		<< row.x
+		<< ","
+		<< row.y
+		<< ","
+		<< row.radius
+		<< std::endl;
+	}
+	outfile.close();
+	return 0;
+}
+
+/**
+ * Appends a summary line to SATURATEDDATA for each Tier which was saturated on a frame.
+ *
+ * @param job FrameJob whose Tiers have all finished
+ * @return status
+ */
+static int write_saturation(const FrameJob &job) {
+	std::ofstream outfile;
+	for (int i = 0; i < 5; i++) {
+		if (job.saturation[i].fill <= 0) {
+			continue;
+		}
+		if (!outfile.is_open()) {
+			outfile.open(SATURATEDDATA, std::ios_base::app);
+		}
+		outfile
+		<< job.framecnt
+		<< ","
+		<< i + 1
+		<< ","
+		<< job.saturation[i].blobs
+		<< ","
+		<< job.saturation[i].fill
+		<< std::endl;
+	}
+	return 0;
+}
+
+/**
+ * Creates an empty reorder buffer.  Sequence numbers must start from zero.
+ *
+ * @param commit function run on each FrameJob, in sequence order
+ */
+ReorderBuffer::ReorderBuffer(std::function<void(FrameJob &)> commit) : commit(commit), next_sequence(0),
+	committing(false) {
+}
+
+/**
+ * Hands a finished FrameJob to the buffer.  The job, and any held jobs which directly follow it, are
+ * committed if it is the next one in sequence.  Otherwise it waits here for the earlier frames.
+ *
+ * Commits run outside the lock so that other workers handing in their jobs do not block on a slow
+ * commit.  Only one thread commits at a time: a thread which finds a commit already running leaves
+ * its job for that thread, which keeps going until it runs out of jobs in sequence.
+ *
+ * @param job FrameJob whose Tiers have all finished
+ */
+void ReorderBuffer::finish(std::shared_ptr<FrameJob> job) {
+	{
+		std::lock_guard<std::mutex> guard(lock);
+		held[job->sequence] = job;
+		if (committing) {
+			return;
+		}
+		committing = true;
+	}
+	while (true) {
+		std::shared_ptr<FrameJob> next;
+		{
+			std::lock_guard<std::mutex> guard(lock);
+			if (held.empty() || held.begin()->first != next_sequence) {
+				committing = false;
+				return;
+			}
+			next = held.begin()->second;
+			held.erase(held.begin());
+			next_sequence++;
+		}
+		commit(*next);
+	}
+}
+
+/**
+ * Creates an empty tracker.
+ */
+Tracker::Tracker() : next_id(1) {
+}
+
+/**
+ * Links the detections of the next frame to the open tracks.  Each track predicts where it will be
+ * from its last position and velocity.  Detection and track pairs within TRACK_GATE pixels of the
+ * prediction are matched nearest first, each detection and track at most once.  Matched tracks move
+ * to the detection and update their velocity, unmatched detections start new tracks, and tracks
+ * which have not been matched for more than TRACK_MAX_MISSED frames are closed.  Tracks are also
+ * closed once they reach TRACK_MAX_LENGTH detections, so a feature of the moon which is detected on
+ * every frame does not keep a track (and its path) growing for the whole video.
+ *
+ * Must be called for every frame, in frame order, including frames without detections.
+ *
+ * @param framecnt int of nth frame retrieved by program
+ * @param rows vector of TierRow detected in this frame
+ */
+void Tracker::update(int framecnt, const vector <TierRow> &rows) {
+	// Candidate pairs of track and detection inside the gate
+	vector <std::tuple<float, size_t, size_t>> pairs;
+	for (size_t t = 0; t < open.size(); t++) {
+		int steps = framecnt - open[t].last_frame;
+		float px = open[t].x + open[t].vx * steps;
+		float py = open[t].y + open[t].vy * steps;
+		for (size_t r = 0; r < rows.size(); r++) {
+			float distance = hypot(rows[r].x - px, rows[r].y - py);
+			if (distance <= TRACK_GATE) {
+				pairs.push_back(std::make_tuple(distance, t, r));
+			}
+		}
+	}
+	std::sort(pairs.begin(), pairs.end());
+
+	vector <bool> track_used(open.size(), false);
+	vector <bool> row_used(rows.size(), false);
+	for (auto &pair : pairs) {
+		size_t t = std::get<1>(pair);
+		size_t r = std::get<2>(pair);
+		if (track_used[t] || row_used[r]) {
+			continue;
+		}
+		track_used[t] = true;
+		row_used[r] = true;
+		Track &track = open[t];
+		int steps = framecnt - track.last_frame;
+		track.vx = (rows[r].x - track.x) / steps;
+		track.vy = (rows[r].y - track.y) / steps;
+		track.distance += hypot(rows[r].x - track.x, rows[r].y - track.y);
+		track.x = rows[r].x;
+		track.y = rows[r].y;
+		track.last_frame = framecnt;
+		track.hits++;
+		track.path += " " + std::to_string(framecnt) + ":" + std::to_string(rows[r].x) + ":"
+			+ std::to_string(rows[r].y);
+	}
+
+	// New tracks
+	for (size_t r = 0; r < rows.size(); r++) {
+		if (row_used[r]) {
+			continue;
+		}
+		Track track;
+		track.start_frame = framecnt;
+		track.last_frame = framecnt;
+		track.start_x = rows[r].x;
+		track.start_y = rows[r].y;
+		track.x = rows[r].x;
+		track.y = rows[r].y;
+		track.vx = 0;
+		track.vy = 0;
+		track.hits = 1;
+		track.distance = 0;
+		track.path = std::to_string(framecnt) + ":" + std::to_string(rows[r].x) + ":"
+			+ std::to_string(rows[r].y);
+		open.push_back(track);
+	}
+
+	// Close lost tracks
+	vector <Track> still_open;
+	for (auto &track : open) {
+		if ((framecnt - track.last_frame > TRACK_MAX_MISSED)
+			|| ((TRACK_MAX_LENGTH > 0) && (track.hits >= TRACK_MAX_LENGTH))) {
+			close(track);
+		} else {
+			still_open.push_back(track);
+		}
+	}
+	open.swap(still_open);
+}
+
+/**
+ * Closes every open track.  Called once after the last frame.
+ */
+void Tracker::finish() {
+	for (auto &track : open) {
+		close(track);
+	}
+	open.clear();
+}
+
+/**
+ * Writes a closed track to TRACKDATA if it has at least TRACK_MIN_LENGTH detections and moved at
+ * least TRACK_MIN_SPEED pixels per frame from its start to its end.  Shorter tracks are usually
+ * noise and slower ones are features of the moon, so both are dropped.
+ *
+ * @param track Track which is no longer followed
+ */
+void Tracker::close(Track &track) {
+	if (track.hits < TRACK_MIN_LENGTH) {
+		return;
+	}
+	int frames = track.last_frame - track.start_frame;
+	double net = hypot(track.x - track.start_x, track.y - track.start_y);
+	if (net < TRACK_MIN_SPEED * frames) {
+		return;
+	}
+	double speed = (frames > 0) ? (track.distance / frames) : 0;
+	std::ofstream outfile;
+	outfile.open(TRACKDATA, std::ios_base::app);
+	outfile
+	<< next_id++
+	<< ","
+	<< track.start_frame
+	<< ","
+	<< track.last_frame
+	<< ","
+	<< track.hits
+	<< ","
+	<< track.start_x
+	<< ","
+	<< track.start_y
+	<< ","
+	<< track.x
+	<< ","
+	<< track.y
+	<< ","
+	<< speed
+	<< ","
+	<< track.path
+	<< std::endl;
+	outfile.close();
+}
+
+/**
+ * Filter chain of the look-back rescan: the Tier 2 adaptive threshold with the more sensitive
+ * LOOKBACK_AT_CONSTANT.
+ *
+ * @param in_frame OpenCV matrix image, 16-bit single depth format
+ * @param old_frame unused by this chain
+ * @param older_frame unused by this chain
+ * @return mask binary mask of the candidate silhouettes, in SCRATCH
+ */
+static Mat tier_lookback(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame) {
+	KERNELS.t2_threshold(in_frame, SCRATCH.mask,
+		T2_AT_MAX,
+		T2_AT_BLOCKSIZE,
+		LOOKBACK_AT_CONSTANT
+	);
+	return SCRATCH.mask;
+}
+
+/**
+ * Runs one held frame through tier_lookback() and keeps its rows (or its saturation summary, as Tier
+ * 6) in the HeldFrame.  Runs on a worker thread, one task per frame.
+ *
+ * @param held HeldFrame to rescan, receives the results
+ */
+static void rescan_frame(HeldFrame &held) {
+	// Frames skipped by the motion gate or decimation never had their moon edge found
+	if (held.bigone.empty()) {
+		held.bigone = qhe_bigone(held.frame);
+	}
+	Rect area = moon_rect(held.bigone, held.frame.size());
+	Mat mask = region_mask(held.frame, Mat(), Mat(), area, vector <Rect>(1, area), tier_margin(2),
+		tier_lookback);
+	if (CONTOUR_TIERS) {
+		tier_contours(held.framecnt, 6, mask, area.tl(), held.bigone, T2_DYMASK, held.rows,
+			held.saturation);
+	} else {
+		tier_blobs(held.framecnt, 6, mask, area.tl(), held.bigone, T2_DYMASK, held.rows,
+			held.saturation);
+	}
+}
+
+/**
+ * Creates an empty look-back window.
+ */
+LookBack::LookBack() : pool(nullptr), last_rescanned(-1) {
+}
+
+/**
+ * Sets the pool the rescans run on.  Must be called before the first commit().
+ *
+ * @param workers TaskPool which runs the rescans, kept until finish()
+ */
+void LookBack::start(TaskPool &workers) {
+	pool = &workers;
+}
+
+/**
+ * Adds a committed frame to the window.  If the trigger Tier (LOOKBACK_TIER) found something in it,
+ * the frames held in the window which were not rescanned yet are handed to the pool as one task
+ * graph, a rescan_frame() task per frame, so the commit thread does not wait for them.  Finished
+ * batches are written on later calls, oldest first, so LookBack.csv stays in frame order.  Frames
+ * are held by reference, so the window copies no pixels.  Called in frame order from commit_frame().
+ *
+ * @param job FrameJob whose Tiers have all finished
+ */
+void LookBack::commit(FrameJob &job) {
+	write_done();
+	if (!job.tier_rows[LOOKBACK_TIER - 1].empty()) {
+		auto batch = std::make_shared<LookBackBatch>();
+		batch->done = false;
+		for (auto &held : window) {
+			if (held.framecnt > last_rescanned) {
+				last_rescanned = held.framecnt;
+				batch->frames.push_back(held);
+			}
+		}
+		if (!batch->frames.empty()) {
+			// The batch owns its graph, so the tasks hold a plain pointer.  The batch stays queued
+			// until done is set, which is the last thing its tasks touch.
+			LookBackBatch *scan = batch.get();
+			batch->graph = std::make_shared<TaskGraph>();
+			int done = batch->graph->add_task([scan] {
+				scan->done = true;
+			});
+			for (size_t i = 0; i < batch->frames.size(); i++) {
+				int rescan = batch->graph->add_task([scan, i] {
+					rescan_frame(scan->frames[i]);
+				});
+				batch->graph->add_edge(rescan, done);
+			}
+			batches.push_back(batch);
+			batch->graph->launch(*pool);
+			if (DEBUG_COUT) {
+				LOGGING.open(LOGOUT, std::ios_base::app);
+				LOGGING
+				<< "Look-back rescanning " << batch->frames.size() << " frames before frame "
+				<< job.framecnt
+				<< std::endl;
+				LOGGING.close();
+			}
+		}
+	}
+	window.push_back({job.framecnt, job.frame, job.bigone, vector <TierRow>(), Saturation()});
+	while (static_cast<int>(window.size()) > LOOKBACK_FRAMES) {
+		window.pop_front();
+	}
+}
+
+/**
+ * Waits for every rescan still running and writes them.  Called once after the last frame has been
+ * committed, before the pool is stopped, from outside the pool.
+ */
+void LookBack::finish() {
+	for (auto &batch : batches) {
+		batch->graph->wait();
+	}
+	write_done();
+}
+
+/**
+ * Writes the finished batches at the front of the queue: their rows to LookBack.csv and, for frames
+ * the rescan gave up on, a Tier 6 line to saturated.csv.  Stops at the first batch still running, so
+ * batches are written in the order they were started.
+ */
+void LookBack::write_done() {
+	while (!batches.empty() && batches.front()->done) {
+		for (auto &held : batches.front()->frames) {
+			write_tier_rows(LOOKBACKFILE, held.rows);
+			if (held.saturation.fill > 0) {
+				std::ofstream outfile;
+				outfile.open(SATURATEDDATA, std::ios_base::app);
+				outfile
+				<< held.framecnt
+				<< ","
+				<< 6
+				<< ","
+				<< held.saturation.blobs
+				<< ","
+				<< held.saturation.fill
+				<< std::endl;
+				outfile.close();
+			}
+		}
+		batches.pop_front();
+	}
+}
+
+/**
+ * Creates a classifier with no model.  load() must succeed before chips are added.
+ */
+Classifier::Classifier() : pool(nullptr) {
+}
+
+/**
+ * Loads the classifier model and sets it up to run on the CPU with OpenCV's own backend.
+ *
+ * @param model path to the model, in any format dnn::readNet() understands (e.g. ONNX)
+ * @return status
+ */
+int Classifier::load(std::string model) {
+	try {
+		net = dnn::readNet(model);
+	} catch (const std::exception &e) {
+		std::cerr << "WARNING: Could not load classifier model " << model << " with error: " << e.what()
+		<< std::endl;
+		return 1;
+	}
+	if (net.empty()) {
+		std::cerr << "WARNING: Classifier model " << model << " is empty" << std::endl;
+		return 1;
+	}
+	net.setPreferableBackend(dnn::DNN_BACKEND_OPENCV);
+	net.setPreferableTarget(dnn::DNN_TARGET_CPU);
+	return 0;
+}
+
+/**
+ * Scores a batch of CLASSIFY_BATCH test chips (flat gray levels from black to white) with the loaded
+ * model, and scores the first and last chip again on their own.  Fails if the model does not give
+ * one finite score per chip, or if a chip scores differently alone than in the batch, which would
+ * mean the batch is laid out in a way the model does not expect.  Called at startup when CLASSIFY is
+ * set, and by --self-test with the stand-in model (models/classifier_stand_in.onnx) unless
+ * CLASSIFY_MODEL is set.
+ *
+ * @return status
+ */
+int Classifier::check() {
+	int count = std::max(2, CLASSIFY_BATCH);
+	vector <Mat> chips;
+	for (int i = 0; i < count; i++) {
+		chips.push_back(Mat(CLASSIFY_CHIP, CLASSIFY_CHIP, CV_8UC1, Scalar(255 * i / (count - 1))));
+	}
+	Mat scores;
+	if (score(chips, scores)) {
+		return 1;
+	}
+	if (!checkRange(scores)) {
+		std::cerr << "WARNING: Classifier gave a score which is not finite" << std::endl;
+		return 1;
+	}
+	for (int i : {0, count - 1}) {
+		Mat alone;
+		if (score(vector <Mat>(1, chips[i]), alone)) {
+			return 1;
+		}
+		float batched = scores.at<float>(i, scores.cols - 1);
+		float single = alone.at<float>(0, alone.cols - 1);
+		if (std::abs(batched - single) > 1e-4 * std::max(1.0f, std::abs(single))) {
+			std::cerr << "WARNING: Classifier scored chip " << i << " as " << batched << " in a batch and "
+			<< single << " alone" << std::endl;
+			return 1;
+		}
+	}
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Classifier check scored " << count << " chips from " << scores.at<float>(0, scores.cols - 1)
+		<< " to " << scores.at<float>(count - 1, scores.cols - 1)
+		<< std::endl;
+		LOGGING.close();
+	}
+	return 0;
+}
+
+/**
+ * Sets the pool the forward passes run on.  Must be called before the first add().
+ *
+ * @param workers TaskPool which runs the forward passes, kept until finish()
+ */
+void Classifier::start(TaskPool &workers) {
+	pool = &workers;
+}
+
+/**
+ * Crops a CLASSIFY_CHIP square chip around every row the Tiers found in a frame, and hands the batch
+ * to the pool each time CLASSIFY_BATCH chips are waiting.  Only the cropping, a small copy per chip,
+ * runs on the commit thread, so the commit thread never waits for the model and frames are not held
+ * while a batch fills up.  Finished batches are written on
+ * later calls, oldest first, so classified.csv stays in frame order.  Called in frame order from
+ * commit_frame().
+ *
+ * @param job FrameJob whose Tiers have all finished
+ */
+void Classifier::add(FrameJob &job) {
+	write_done();
+	int tiers = TIER5 ? 5 : 4;
+	for (int i = 0; i < tiers; i++) {
+		for (auto &row : job.tier_rows[i]) {
+			if (!filling) {
+				filling = std::make_shared<ClassifyBatch>();
+				filling->done = false;
+			}
+			Mat chip;
+			// Chips reaching past the edge of the frame are filled by replicating the edge
+			getRectSubPix(job.frame, Size(CLASSIFY_CHIP, CLASSIFY_CHIP), Point2f(row.x, row.y), chip);
+			filling->chips.push_back(chip);
+			filling->rows.push_back(std::make_pair(i + 1, row));
+			if (static_cast<int>(filling->chips.size()) >= std::max(1, CLASSIFY_BATCH)) {
+				launch();
+			}
+		}
+	}
+}
+
+/**
+ * Scores the partly filled batch, waits for every batch still running and writes them.  Called once
+ * after the last frame has been committed, before the pool is stopped, from outside the pool.
+ */
+void Classifier::finish() {
+	if (filling) {
+		launch();
+	}
+	for (auto &batch : batches) {
+		batch->graph->wait();
+	}
+	write_done();
+}
+
+/**
+ * Runs the model on a batch of chips.  The chips go in as a batch of single channel images scaled to
+ * 0..1, and the last value the model outputs for each chip is its score.  The net is not safe to run
+ * from two threads at once, so forward passes take turns; OpenCV spreads each one over its own
+ * threads.
+ *
+ * @param chips single channel chips of CLASSIFY_CHIP pixels
+ * @param scores output with a row per chip, copied out of the net's buffers
+ * @return status
+ */
+int Classifier::score(const vector <Mat> &chips, Mat &scores) {
+	std::lock_guard<std::mutex> lock(net_lock);
+	try {
+		Mat blob = dnn::blobFromImages(chips, 1.0/255);
+		net.setInput(blob);
+		Mat out = net.forward();
+		if (out.total() == 0 || out.total() % chips.size() != 0) {
+			std::cerr << "WARNING: Classifier gave " << out.total() << " values for a batch of "
+			<< chips.size() << " chips" << std::endl;
+			return 1;
+		}
+		// The output lives in the net, and is overwritten by the next forward pass
+		scores = out.reshape(1, static_cast<int>(chips.size())).clone();
+	} catch (const std::exception &e) {
+		std::cerr << "WARNING: Classifier failed on a batch of " << chips.size() << " chips with error: "
+		<< e.what() << std::endl;
+		return 1;
+	}
+	return 0;
+}
+
+/**
+ * Hands the filling batch to the pool as a one task graph and starts a new one.
+ */
+void Classifier::launch() {
+	auto batch = filling;
+	filling.reset();
+	// The batch owns its graph, so the task holds a plain pointer
+	ClassifyBatch *run = batch.get();
+	batch->graph = std::make_shared<TaskGraph>();
+	batch->graph->add_task([this, run] {
+		if (score(run->chips, run->scores)) {
+			run->scores.release();
+		}
+		run->chips.clear();
+		run->done = true;
+	});
+	batches.push_back(batch);
+	batch->graph->launch(*pool);
+}
+
+/**
+ * Appends a line with the score of each chip of the finished batches at the front of the queue to
+ * CLASSDATA.  Stops at the first batch still running, so batches are written in the order they were
+ * started.  A batch the model failed on writes nothing.
+ */
+void Classifier::write_done() {
+	while (!batches.empty() && batches.front()->done) {
+		ClassifyBatch &batch = *batches.front();
+		if (!batch.scores.empty()) {
+			std::ofstream outfile;
+			outfile.open(CLASSDATA, std::ios_base::app);
+			for (size_t i = 0; i < batch.rows.size(); i++) {
+				outfile
+				<< batch.rows[i].second.framecnt
+				<< ","
+				<< batch.rows[i].first
+				<< ","
+				<< batch.rows[i].second.x
+				<< ","
+				<< batch.rows[i].second.y
+				<< ","
+				<< batch.rows[i].second.radius
+				<< ","
+				<< batch.scores.at<float>(i, batch.scores.cols - 1)
+				<< std::endl;
+			}
+			outfile.close();
+			if (DEBUG_COUT) {
+				LOGGING.open(LOGOUT, std::ios_base::app);
+				LOGGING << "Classified a batch of " << batch.rows.size() << " chips" << std::endl;
+				LOGGING.close();
+			}
+		}
+		batches.pop_front();
+	}
+}
+
+/**
+ * Runs the ordered Tier 5, writes the rows of a frame to the Tier files, feeds the tracker, the
+ * look-back window and the classifier.  Called by the ReorderBuffer in frame order.
+ *
+ * @param job FrameJob whose Tiers have all finished
+ */
+static void commit_frame(FrameJob &job) {
+	if (TIER5) {
+		tier_five(job);
+	}
+	write_saturation(job);
+	write_tier_rows(TIER1FILE, job.tier_rows[0]);
+	write_tier_rows(TIER2FILE, job.tier_rows[1]);
+	write_tier_rows(TIER3FILE, job.tier_rows[2]);
+	write_tier_rows(TIER4FILE, job.tier_rows[3]);
+	if (TIER5) {
+		write_tier_rows(TIER5FILE, job.tier_rows[4]);
+	}
+	if (TRACKING) {
+		TRACKER.update(job.framecnt, job.tier_rows[TRACK_TIER - 1]);
+	}
+	if (LOOKBACK_FRAMES > 0) {
+		LOOKBACK.commit(job);
+	}
+	if (CLASSIFY) {
+		CLASSIFIER.add(job);
+	}
+}
+
+/**
+ * Creates an empty cascade.
+ */
+Cascade::Cascade() {
+}
+
+/**
+ * Queues a frame whose cheap stage (Tiers 1 and 2) has been launched.
+ *
+ * @param job FrameJob of the frame
+ * @param cheap graph running the cheap stage of the frame
+ */
+void Cascade::add(std::shared_ptr<FrameJob> job, std::shared_ptr<TaskGraph> cheap) {
+	pending.push_back(std::make_pair(job, cheap));
+}
+
+/**
+ * Decides whether the oldest queued frame needs Tiers 3 and 4, and where.  A frame needs them if
+ * Tier 1 or Tier 2 found something in it or in any frame up to CASCADE_FRAMES before or after it.
+ * With CASCADE = 2 the frame's regions are also cut down to the boxes around those detections, grown
+ * by CASCADE_PAD pixels.  Only Tier 3 is narrowed to the boxes; Tier 4 still runs on the whole moon
+ * (see run_tier()).  The boxes hold no lunar ellipse, and a bird filling its box is not mistaken for
+ * one, since lunar_ellipse() goes by the bounds of bigone rather than by size.  With CONTOUR_TIERS the
+ * largest contour of each mask is still dropped as the ellipse, so a bird alone in its box is lost.
+ * The decision is made once CASCADE_FRAMES later frames have been queued, so the oldest frame is only
+ * returned when its whole neighbourhood has finished the cheap stage.
+ *
+ * Must be called from the thread which calls add().
+ *
+ * @param flush decide the oldest frame even without CASCADE_FRAMES later frames (end of video)
+ * @return job FrameJob ready for the expensive stage, or nullptr if none is ready yet
+ */
+std::shared_ptr<FrameJob> Cascade::next(bool flush) {
+	if (pending.empty() || (!flush && (static_cast<int>(pending.size()) <= CASCADE_FRAMES))) {
+		return nullptr;
+	}
+	size_t ahead = std::min(pending.size(), static_cast<size_t>(CASCADE_FRAMES) + 1);
+	vector <Rect> window;
+	for (auto &hits : past) {
+		window.insert(window.end(), hits.begin(), hits.end());
+	}
+	vector <Rect> current;
+	for (size_t i = 0; i < ahead; i++) {
+		pending[i].second->wait();
+		vector <Rect> hits = cascade_hits(*pending[i].first);
+		window.insert(window.end(), hits.begin(), hits.end());
+		if (i == 0) {
+			current = hits;
+		}
+	}
+	std::shared_ptr<FrameJob> job = pending.front().first;
+	pending.pop_front();
+	past.push_back(current);
+	while (static_cast<int>(past.size()) > CASCADE_FRAMES) {
+		past.pop_front();
+	}
+
+	if (window.empty()) {
+		job->skip_expensive = true;
+	} else if (CASCADE == 2) {
+		// Merge overlapping boxes so no pixel is filtered twice
+		bool merged = true;
+		while (merged) {
+			merged = false;
+			for (size_t i = 0; i < window.size() && !merged; i++) {
+				for (size_t j = i + 1; j < window.size(); j++) {
+					if ((window[i] & window[j]).area() > 0) {
+						window[i] |= window[j];
+						window.erase(window.begin() + j);
+						merged = true;
+						break;
+					}
+				}
+			}
+		}
+		vector <Rect> regions;
+		for (auto &region : job->regions) {
+			for (auto &box : window) {
+				Rect overlap = region & box;
+				if (!overlap.empty()) {
+					regions.push_back(overlap);
+				}
+			}
+		}
+		job->regions = regions;
+		job->skip_expensive = regions.empty();
+	}
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Cascade for frame " << job->framecnt << ": "
+		<< (job->skip_expensive ? "skipping Tiers 3 and 4" : "running Tiers 3 and 4")
+		<< " on " << job->regions.size() << " regions"
+		<< std::endl;
+		LOGGING.close();
+	}
+	return job;
+}
+
+/**
+ * Boxes around the Tier 1 and Tier 2 detections of a frame, grown by CASCADE_PAD pixels.
+ *
+ * @param job FrameJob whose cheap stage has finished
+ * @return hits vector of OpenCV Rect, in frame coordinates
+ */
+static vector <Rect> cascade_hits(FrameJob &job) {
+	vector <Rect> hits;
+	for (int tier = 0; tier < 2; tier++) {
+		for (auto &row : job.tier_rows[tier]) {
+			int reach = static_cast<int>(ceil(row.radius)) + CASCADE_PAD;
+			hits.push_back(Rect(row.x - reach, row.y - reach, 2*reach + 1, 2*reach + 1));
+		}
+	}
+	return hits;
+}
+
+/**
+ * Creates an empty decimator.
+ */
+Decimator::Decimator() : added(0), last_hit(false) {
+}
+
+/**
+ * Tells whether the next frame to be added is one of the sampled frames, every DECIMATE frames.
+ * Sampled frames get their full graph launched before they are added.
+ *
+ * @return true if the next frame is sampled
+ */
+bool Decimator::sampled() {
+	return (added % std::max(1, DECIMATE)) == 0;
+}
+
+/**
+ * Queues the next frame in frame order.
+ *
+ * @param job FrameJob of the frame
+ * @param graph graph launched for a sampled frame, nullptr for a frame held back
+ */
+void Decimator::add(std::shared_ptr<FrameJob> job, std::shared_ptr<TaskGraph> graph) {
+	pending.push_back(std::make_pair(job, graph));
+	added++;
+}
+
+/**
+ * Returns the next held back frame once it is known whether it needs the Tiers.  A held back frame is
+ * processed if the sampled frame before it or the sampled frame after it found anything in Tiers 1
+ * to 4, so a bird seen in a sample gets every frame around it.  Otherwise it keeps skip_tiers set and
+ * only passes through the reorder buffer.  Sampled frames are dropped from the queue as they are
+ * passed.
+ *
+ * Must be called from the thread which calls add().
+ *
+ * @param flush decide frames even without a later sampled frame (end of video)
+ * @return job FrameJob ready to be launched, or nullptr if none is ready yet
+ */
+std::shared_ptr<FrameJob> Decimator::next(bool flush) {
+	// Retire the sampled frames at the front
+	while (!pending.empty() && pending.front().second) {
+		pending.front().second->wait();
+		last_hit = frame_hit(*pending.front().first);
+		pending.pop_front();
+	}
+	if (pending.empty()) {
+		return nullptr;
+	}
+
+	// The held back frame at the front waits for the next sampled frame
+	bool next_hit = false;
+	bool found = false;
+	for (auto &entry : pending) {
+		if (entry.second) {
+			entry.second->wait();
+			next_hit = frame_hit(*entry.first);
+			found = true;
+			break;
+		}
+	}
+	if (!found && !flush) {
+		return nullptr;
+	}
+
+	std::shared_ptr<FrameJob> job = pending.front().first;
+	pending.pop_front();
+	if (!last_hit && !next_hit) {
+		job->skip_tiers = true;
+	}
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Decimation for frame " << job->framecnt << ": "
+		<< (job->skip_tiers ? "skipped" : "refined")
+		<< std::endl;
+		LOGGING.close();
+	}
+	return job;
+}
+
+/**
+ * Tells whether the trigger Tier (DECIMATE_TIER) found something in a frame.  One Tier is used
+ * rather than any of them, since the noisy Tiers find something on nearly every frame.
+ *
+ * @param job FrameJob whose graph has finished
+ * @return true if the trigger Tier has a row for this frame
+ */
+static bool frame_hit(FrameJob &job) {
+	return !job.tier_rows[DECIMATE_TIER - 1].empty();
+}
+
+/**
+ * Builds the task graph for one centered frame:
+ *
+ *     (bigone, tiles) -> (Tier 1, Tier 2, Tier 3, Tier 4) -> write
+ *
+ * The four Tiers only read the centered frames, so each one works on its own copy and they may run
+ * in any order on any worker.  The tiles task finds the regions the Tiers run on.  The write task
+ * passes the frame to the ReorderBuffer once all are done, which appends the rows in Tier order as
+ * soon as every earlier frame has been written.  A frame skipped by the motion gate gets a graph
+ * holding only the write task.
+ *
+ * In cascade mode the graph is split in two stages.  STAGE_CHEAP holds bigone, tiles, Tier 1 and
+ * Tier 2.  STAGE_EXPENSIVE holds Tier 3, Tier 4 and the write task, and is built after the Cascade
+ * has decided whether the frame needs Tiers 3 and 4.
+ *
+ * @param job FrameJob holding the centered frame and the previous centered frame
+ * @param committer ReorderBuffer which writes the finished frames in order
+ * @param stage STAGE_ALL, STAGE_CHEAP or STAGE_EXPENSIVE
+ * @return graph ready to be launched on a TaskPool
+ */
+static std::shared_ptr<TaskGraph> frame_graph(std::shared_ptr<FrameJob> job, ReorderBuffer &committer,
+	int stage) {
+	auto graph = std::make_shared<TaskGraph>();
+	bool cheap = (stage != STAGE_EXPENSIVE);
+	bool expensive = (stage != STAGE_CHEAP) && !job->skip_expensive;
+	// Frames skipped by the motion gate still pass through the reorder buffer to keep the order
+	if (job->skip_tiers) {
+		cheap = false;
+		expensive = false;
+	}
+	int bigone = -1;
+	int tiles = -1;
+	if (cheap) {
+		bigone = graph->add_task([job] {
+			job->bigone = qhe_bigone(job->frame);
+			if ((job->bigone[0].x < 0) && (job->bigone[0].y < 0)) {
+				std::cerr
+				<< "WARNING: largest frame returned error, beware tiers for frame: "
+				<< job->framecnt
+				<< std::endl;
+			}
+		});
+		tiles = graph->add_task([job] {
+			job->regions = dirty_regions(job->frame, job->old_frame);
+		});
+	}
+	vector <int> tiers;
+	for (int i = 0; i < 4; i++) {
+		if ((i < 2) ? cheap : expensive) {
+			tiers.push_back(graph->add_task([job, i] {
+				run_tier(i + 1, *job);
+			}));
+			if (cheap) {
+				graph->add_edge(bigone, tiers.back());
+				graph->add_edge(tiles, tiers.back());
+			}
+		}
+	}
+	if (stage != STAGE_CHEAP) {
+		int write = graph->add_task([job, &committer] {
+			committer.finish(job);
+		});
+		for (auto tier : tiers) {
+			graph->add_edge(tier, write);
+		}
+	}
+	return graph;
+}
+
+/**
+ * Loads the keyframe index of a video into KEYFRAMES, building it first if needed.  The index lists
+ * the frame number, presentation timestamp and time in seconds of every keyframe, and is kept in a
+ * sidecar file next to the video (video.mp4.kfidx) so later runs can reuse it.  A sidecar made for a
+ * file of a different size is rebuilt.
+ *
+ * The index is built from the packets with ffprobe, without decoding any frames.  Frame numbers are
+ * the packets' positions in presentation order, which matches the frame count used by the rest of
+ * the program.  Reading every packet still takes a while on a long video, so the index is only
+ * loaded by the runs which seek: the quick look and a NON_ZERO_START past the first frame.
+ *
+ * @param input_file path to the video
+ * @return status
+ */
+static int load_keyframe_index(std::string input_file) {
+	KEYFRAMES.clear();
+	std::string index_file = input_file + ".kfidx";
+	std::error_code error;
+	uintmax_t video_size = fs::file_size(input_file, error);
+	if (error) {
+		std::cerr << "WARNING: Could not read the size of " << input_file
+		<< ", running without a keyframe index" << std::endl;
+		return 1;
+	}
+	std::string size_line = "video size," + std::to_string(video_size);
+
+	// Reuse the sidecar if it belongs to this video
+	std::ifstream infile(index_file);
+	if (infile.is_open()) {
+		std::string line;
+		if (std::getline(infile, line) && (line == size_line)) {
+			// Skip the column names
+			std::getline(infile, line);
+			while (std::getline(infile, line)) {
+				KEYFRAMES.push_back(std::stoi(line.substr(0, line.find(","))));
+			}
+			if (DEBUG_COUT) {
+				LOGGING.open(LOGOUT, std::ios_base::app);
+				LOGGING << "Loaded " << KEYFRAMES.size() << " keyframes from " << index_file << std::endl;
+				LOGGING.close();
+			}
+			return 0;
+		}
+		infile.close();
+	}
+
+	if (system("ffprobe -version > /dev/null 2>&1")) {
+		std::cerr << "WARNING: ffprobe is not available, running without a keyframe index" << std::endl;
+		return 1;
+	}
+	std::string command = "ffprobe -v error -select_streams v:0 -show_entries packet=pts,pts_time,flags"
+		" -of csv=p=0 " + space_space(input_file);
+	FILE *pipe = popen(command.c_str(), "r");
+	if (pipe == NULL) {
+		std::cerr << "WARNING: Could not run ffprobe with error: " << strerror(errno) << std::endl;
+		return 1;
+	}
+	// Each line is pts,pts_time,flags and the flags of a keyframe start with K
+	vector <std::tuple<long long, std::string, bool>> packets;
+	char buffer[256];
+	while (fgets(buffer, sizeof(buffer), pipe) != NULL) {
+		std::stringstream ss(buffer);
+		std::string pts, pts_time, flags;
+		if (!std::getline(ss, pts, ',') || !std::getline(ss, pts_time, ',') || !std::getline(ss, flags)) {
+			continue;
+		}
+		if (pts == "N/A") {
+			continue;
+		}
+		packets.push_back(std::make_tuple(std::stoll(pts), pts_time, flags[0] == 'K'));
+	}
+	if (pclose(pipe) != 0) {
+		std::cerr << "WARNING: ffprobe failed on " << input_file << ", running without a keyframe index"
+		<< std::endl;
+		return 1;
+	}
+	std::sort(packets.begin(), packets.end());
+
+	std::ofstream outfile(index_file);
+	outfile
+	<< size_line
+	<< std::endl
+	<< "frame number"
+	<< ","
+	<< "pts"
+	<< ","
+	<< "pts time"
+	<< std::endl;
+	for (size_t i = 0; i < packets.size(); i++) {
+		if (std::get<2>(packets[i])) {
+			KEYFRAMES.push_back(i);
+			outfile
+			<< i
+			<< ","
+			<< std::get<0>(packets[i])
+			<< ","
+			<< std::get<1>(packets[i])
+			<< std::endl;
 		}
 	}
+	outfile.close();
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING
+		<< "Indexed " << packets.size() << " packets with " << KEYFRAMES.size() << " keyframes into "
+		<< index_file << std::endl;
+		LOGGING.close();
+	}
 	return 0;
 }
 
 /**
- * This is the third pass to detect valid contours in a frame.  The parameters of the function are
- * set in the T3 section of settings.cfg.  The detector performs an isotropic Laplacian on the current
- * frame and the previous frame (settings.cfg can be modified for anisotropic Laplacian).  The outputs
- * are blurred and recombined.  Values passing a cutoff threshold are retained and the contours are
- * detected.
+ * Finds the keyframe a seek should start from.
  *
- * @param framecnt int of nth frame retrieved by program
- * @param in_frame OpenCV matrix image, 16-bit single depth format
- * @param old_frame OpenCV matrix image, 16-bit single depth format, stored from previous cycle
- * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
- * @return status
+ * @param framecnt frame number wanted
+ * @param after true for the first keyframe at or after framecnt, false for the last one at or before
+ * @return keyframe frame number, or framecnt if there is no index or no such keyframe
  */
-int tier_three(int framecnt, Mat in_frame, Mat old_frame, vector <Point> bigone) {
-	Point2f center;
-	float radius;
-	float bigradius = 0;
-	std::ofstream outfile;
-	Mat scaleframe;
-
-	/* Eli Method for Tier 3 */
-	Laplacian(in_frame.clone(), in_frame, CV_32F,
-		T3_LAP_KERNEL,
-		T3_LAP_SCALE,
-		T3_LAP_DELTA,
-		BORDER_DEFAULT
-	);
-	Laplacian(old_frame.clone(), old_frame, CV_32F,
-		T3_LAP_KERNEL,
-		T3_LAP_SCALE,
-		T3_LAP_DELTA,
-		BORDER_DEFAULT
-	);
-	GaussianBlur(in_frame.clone(), in_frame,
-		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
-		T3_GB_SIGMA_X,
-		T3_GB_SIGMA_Y,
-		BORDER_DEFAULT
-	);
-	GaussianBlur(old_frame.clone(), old_frame,
-		Size(T3_GB_KERNEL_X, T3_GB_KERNEL_Y),
-		T3_GB_SIGMA_X,
-		T3_GB_SIGMA_Y,
-		BORDER_DEFAULT
-	);
-	scaleframe = in_frame.clone() - old_frame.clone();
-	scaleframe = scaleframe.clone() > T3_CUTOFF_THRESH;
-	/* end Eli Method */
-	// Apply dynamic mask
-	scaleframe = apply_dynamic_mask(scaleframe.clone(), bigone, T3_DYMASK);
-	vector <vector<Point>> contours = contours_only(scaleframe);
-	if (contours.size() > 0) {
-		contours = quiet_halo_elim(contours, bigone);
-
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Number of contours in tier 3 pass for frame "
-			<< framecnt
-			<< ": "
-			<< contours.size()
-			<< std::endl;
-			LOGGING.close();
-		}
-		int largest_contour_index = largest_contour(contours);
-		if (largest_contour_index > -1) {
-			minEnclosingCircle(contours[largest_contour_index], center, bigradius);
-		}
-		outfile.open(TIER3FILE, std::ios_base::app);
-		// Cycle through the contours
-		for (auto vec : contours) {
-			// Greater than one includes lunar ellipse
-			if (vec.size() > 1) {
-				minEnclosingCircle(vec, center, radius);
-				if (radius != bigradius) {
-					// Open the outfile to append
-					outfile
-					<< framecnt
-					<< ","
-					<< static_cast<int>(center.x)
-					<< ","
-					<< static_cast<int>(center.y)
-					<< ","
-					<< radius
-					<< std::endl;
-				}
-			}
-		}
-		outfile.close();
-	} else {
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Found too few contours for frame " << framecnt << " Tier "
-			<< "3 "
-			<< "skipping this tier for this frame."
-			<< std::endl;
-			LOGGING.close();
-		}
+static int nearest_keyframe(int framecnt, bool after) {
+	if (KEYFRAMES.empty()) {
+		return framecnt;
 	}
-	return 0;
+	if (after) {
+		auto key = std::lower_bound(KEYFRAMES.begin(), KEYFRAMES.end(), framecnt);
+		return (key == KEYFRAMES.end()) ? framecnt : *key;
+	}
+	auto key = std::upper_bound(KEYFRAMES.begin(), KEYFRAMES.end(), framecnt);
+	return (key == KEYFRAMES.begin()) ? framecnt : *(key - 1);
 }
 
 /**
- * This is the fourth pass to detect valid contours in a frame.  The parameters of the function are
- * set in the T4 section of settings.cfg.  This is the UnCanny method for detecting motion.  The steps
- * are essentially the backward operation of the steps taken during Canny filtering.  The current
- * frame is subtracted from the previous frame, and this output is threholded.  The thresholded image
- * is then passed through directional Sobel filters to separate the x and y components.  These
- * components are squared, added to each other, and square rooted.  The output is rescaled to match
- * the input value ranges, and a Gaussian blur is applied.  Since this output is messy, the blurry
- * image is processed using Zhang-Suen thinning to get distinct edges.  Any details lost between the
- * blurring and thinning steps reduce noise.  Contours are then detected in the normal way.
+ * Quick-look survey of a recording, to decide whether it is worth a full run.  Instead of decoding
+ * every frame, the video is sampled every QUICK_LOOK_STEP seconds by seeking, and at each sample two
+ * consecutive frames are decoded.  With KEYFRAME_INDEX set, the keyframe index is loaded first and
+ * each sample moves to the next keyframe, so the seek does not decode the frames leading up to it.
+ * The moon is found as in first_frame() and compared with the calibration frame: the visibility is
+ * the moon's bounding box area over the calibrated one (cloud and the moon leaving the frame lower
+ * it) and the brightness is the mean value inside the moon.  The activity is the fraction of the
+ * moon whose value changed by more than MOTION_GATE_PIXEL between the two frames.  The samples are
+ * summarised per minute of video in quicklook.csv.
  *
- * @param framecnt int of nth frame retrieved by program
- * @param in_frame OpenCV matrix image, 16-bit single depth format
- * @param old_frame OpenCV matrix image, 16-bit single depth format, stored from previous cycle
- * @param bigone vector of Opencv Points representing the largest contour from qhe_bigone
+ * first_frame() must have run first.
+ *
+ * @param input_file path to the video
  * @return status
  */
-int tier_four(int framecnt, Mat in_frame, Mat old_frame, vector <Point> bigone) {
-	Point2f center;
-	float radius;
-	float bigradius = 0;
-	std::ofstream outfile;
-	Mat scaleframe;
+static int quick_look(std::string input_file) {
+	VideoCapture cap(input_file);
+	if (!cap.isOpened()) {
+		std::cerr << "WARNING: Could not open " << input_file << " for the quick look" << std::endl;
+		return 1;
+	}
+	if (KEYFRAME_INDEX) {
+		load_keyframe_index(input_file);
+	}
+	double fps = cap.get(CAP_PROP_FPS);
+	if (fps <= 0) {
+		fps = CONVERT_FPS;
+	}
+	int total = static_cast<int>(cap.get(CAP_PROP_FRAME_COUNT));
+	int step = std::max(1, static_cast<int>(QUICK_LOOK_STEP * fps));
+	int frames_per_minute = std::max(1, static_cast<int>(60 * fps));
 
-	/* UnCanny v2 */
+	std::ofstream outfile;
+	outfile.open(QUICKDATA);
+	outfile
+	<< "minute"
+	<< ","
+	<< "samples"
+	<< ","
+	<< "visible samples"
+	<< ","
+	<< "mean visibility"
+	<< ","
+	<< "mean brightness"
+	<< ","
+	<< "mean activity"
+	<< ","
+	<< "max activity"
+	<< std::endl;
 
-	subtract(in_frame.clone(), old_frame.clone(), in_frame);
-	adaptiveThreshold(in_frame.clone(), in_frame,
-		T4_AT_MAX,
-		ADAPTIVE_THRESH_GAUSSIAN_C,
-		THRESH_BINARY_INV,
-		T4_AT_BLOCKSIZE,
-		T4_AT_CONSTANT
-	);
-	Mat ix1, iy1, ii1;
-	Sobel(in_frame.clone(), ix1, CV_32F, 1, 0);
-	Sobel(in_frame.clone(), iy1, CV_32F, 0, 1);
-	pow(ix1.clone(), T4_POWER, ix1);
-	pow(iy1.clone(), T4_POWER, iy1);
-	add(ix1, iy1, ii1);
-	sqrt(ii1.clone(), ii1);
-	convertScaleAbs(ii1.clone(), ii1);
-	GaussianBlur(ii1.clone(), ii1,
-		Size(T4_GB_KERNEL_X, T4_GB_KERNEL_Y),
-		T4_GB_SIGMA_X,
-		T4_GB_SIGMA_Y,
-		BORDER_DEFAULT
-	);
-	ximgproc::thinning(ii1.clone(), scaleframe, T4_THINNING);
-	
-	/* end UnCanny v2 */
-	
-	// Apply dynamic mask
-	scaleframe = apply_dynamic_mask(scaleframe.clone(), bigone, T4_DYMASK);
-	vector <vector<Point>> contours = contours_only(scaleframe);
-	if (contours.size() > 0) {
-		contours = quiet_halo_elim(contours, bigone);
+	int minute = 0;
+	int samples = 0;
+	int last_sample = -1;
+	int visible = 0;
+	double visibility_sum = 0;
+	double brightness_sum = 0;
+	double activity_sum = 0;
+	double activity_max = 0;
+	for (int framecnt = 0; ; framecnt += step) {
+		int sample = nearest_keyframe(framecnt, true);
+		if (sample == last_sample) {
+			continue;
+		}
+		last_sample = sample;
+		bool done = (total > 0) && (sample >= total);
+		Mat frame, next_frame;
+		if (!done) {
+			cap.set(CAP_PROP_POS_FRAMES, sample);
+			cap >> frame;
+			cap >> next_frame;
+			done = frame.empty() || next_frame.empty();
+		}
 
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Number of contours in tier 4 pass for frame "
-			<< framecnt
-			<< ": "
-			<< contours.size()
+		// Write the finished minute
+		if ((samples > 0) && (done || (sample / frames_per_minute != minute))) {
+			outfile
+			<< minute
+			<< ","
+			<< samples
+			<< ","
+			<< visible
+			<< ","
+			<< visibility_sum / samples
+			<< ","
+			<< ((visible > 0) ? brightness_sum / visible : 0)
+			<< ","
+			<< ((visible > 0) ? activity_sum / visible : 0)
+			<< ","
+			<< activity_max
 			<< std::endl;
-			LOGGING.close();
+			samples = 0;
+			visible = 0;
+			visibility_sum = 0;
+			brightness_sum = 0;
+			activity_sum = 0;
+			activity_max = 0;
 		}
-		int largest_contour_index = largest_contour(contours);
-		if (largest_contour_index > -1) {
-			minEnclosingCircle(contours[largest_contour_index], center, bigradius);
-		}
-		outfile.open(TIER4FILE, std::ios_base::app);
-		// Cycle through the contours
-		for (auto vec : contours) {
-			// Greater than one includes lunar ellipse
-			if (vec.size() > 1) {
-				minEnclosingCircle(vec, center, radius);
-				if (radius != bigradius) {
-					// Open the outfile to append
-					outfile
-					<< framecnt
-					<< ","
-					<< static_cast<int>(center.x)
-					<< ","
-					<< static_cast<int>(center.y)
-					<< ","
-					<< radius
-					<< std::endl;
-				}
+		if (done) {
+			break;
+		}
+		minute = sample / frames_per_minute;
+		samples++;
 
-			}
+		cvtColor(frame, frame, COLOR_BGR2GRAY);
+		cvtColor(next_frame, next_frame, COLOR_BGR2GRAY);
+		Mat temp_frame;
+		threshold(frame, temp_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
+		ContourSet contours = contours_only(temp_frame, CHAIN_APPROX_SIMPLE);
+		int largest = largest_contour(contours);
+		if (largest < 0) {
+			continue;
 		}
-		outfile.close();
-	} else {
-		if (DEBUG_COUT) {
-			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING
-			<< "Found too few contours for frame " << framecnt << " Tier "
-			<< "4 "
-			<< "skipping this tier for this frame."
-			<< std::endl;
-			LOGGING.close();
+		double visibility = boundingRect(contours[largest]).area() / ORIG_AREA;
+		visibility_sum += std::min(visibility, 1.0);
+		if (visibility < QUICK_LOOK_VISIBLE) {
+			continue;
+		}
+		visible++;
+
+		// Moon disc, shrunk so the wobble of the limb does not count as activity
+		Mat disc = Mat::zeros(frame.size(), CV_8UC1);
+		drawContours(disc, contours, largest, 255, FILLED, LINE_8);
+		erode(disc, disc, getStructuringElement(MORPH_RECT, Size(2*QHE_WIDTH + 1, 2*QHE_WIDTH + 1)));
+		int disc_pixels = countNonZero(disc);
+		if (disc_pixels == 0) {
+			continue;
 		}
+		brightness_sum += mean(frame, disc)[0];
+		Mat diff;
+		absdiff(frame, next_frame, diff);
+		Mat changed = (diff > MOTION_GATE_PIXEL) & disc;
+		double activity = static_cast<double>(countNonZero(changed)) / disc_pixels;
+		activity_sum += activity;
+		activity_max = std::max(activity_max, activity);
+	}
+	outfile.close();
+
+	if (DEBUG_COUT) {
+		LOGGING.open(LOGOUT, std::ios_base::app);
+		LOGGING << "Quick look finished, sampled every " << step << " frames" << std::endl;
+		LOGGING.close();
 	}
 	return 0;
 }
@@ -1335,6 +3730,19 @@ int parse_checklist(std::string name, std::string value) {
 		|| name == "SIMP_ELL"
 		|| name == "CONCAT_TIERS"
 		|| name == "TIGHT_CROP"
+		|| name == "MOTION_GATE"
+		|| name == "DIRTY_TILES"
+		|| name == "CONTOUR_TIERS"
+		|| name == "DOUBLE_DIFFERENCE"
+		|| name == "CLASSIFY"
+		|| name == "RECURSIVE_BLUR"
+		|| name == "T1_AT_BOX"
+		|| name == "T2_AT_BOX"
+		|| name == "T4_AT_BOX"
+		|| name == "T3_FIXED_POINT"
+		|| name == "TRACKING"
+		|| name == "TIER5"
+		|| name == "KEYFRAME_INDEX"
 		) {
 		// Define booleans
 		bool result;
@@ -1363,6 +3771,32 @@ int parse_checklist(std::string name, std::string value) {
 			CONCAT_TIERS = result;
 		} else if (name == "TIGHT_CROP") {
 			TIGHT_CROP = result;
+		} else if (name == "MOTION_GATE") {
+			MOTION_GATE = result;
+		} else if (name == "DIRTY_TILES") {
+			DIRTY_TILES = result;
+		} else if (name == "CONTOUR_TIERS") {
+			CONTOUR_TIERS = result;
+		} else if (name == "DOUBLE_DIFFERENCE") {
+			DOUBLE_DIFFERENCE = result;
+		} else if (name == "CLASSIFY") {
+			CLASSIFY = result;
+		} else if (name == "RECURSIVE_BLUR") {
+			RECURSIVE_BLUR = result;
+		} else if (name == "T1_AT_BOX") {
+			T1_AT_BOX = result;
+		} else if (name == "T2_AT_BOX") {
+			T2_AT_BOX = result;
+		} else if (name == "T4_AT_BOX") {
+			T4_AT_BOX = result;
+		} else if (name == "T3_FIXED_POINT") {
+			T3_FIXED_POINT = result;
+		} else if (name == "TRACKING") {
+			TRACKING = result;
+		} else if (name == "TIER5") {
+			TIER5 = result;
+		} else if (name == "KEYFRAME_INDEX") {
+			KEYFRAME_INDEX = result;
 		}
 	}
 	// Int cases
@@ -1372,6 +3806,24 @@ int parse_checklist(std::string name, std::string value) {
 		|| name == "BLACKOUT_THRESH"
 		|| name == "CONVERT_FPS"
 		|| name == "NON_ZERO_START"
+		|| name == "WORKER_THREADS"
+		|| name == "IN_FLIGHT_FRAMES"
+		|| name == "MOTION_GATE_PIXEL"
+		|| name == "MOTION_GATE_WARMUP"
+		|| name == "TILE_SIZE"
+		|| name == "MOON_LOST_LIMIT"
+		|| name == "REACQUIRE_SCALE"
+		|| name == "TILE_PIXEL"
+		|| name == "TILE_MIN_PIXELS"
+		|| name == "TRACK_TIER"
+		|| name == "LOOKBACK_FRAMES"
+		|| name == "LOOKBACK_TIER"
+		|| name == "CLASSIFY_CHIP"
+		|| name == "MAX_CONTOURS"
+		|| name == "CLASSIFY_BATCH"
+		|| name == "TRACK_MAX_MISSED"
+		|| name == "TRACK_MIN_LENGTH"
+		|| name == "TRACK_MAX_LENGTH"
 		|| name == "T1_AT_BLOCKSIZE"
 		|| name == "T1_DYMASK"
 		|| name == "T2_AT_BLOCKSIZE"
@@ -1381,6 +3833,14 @@ int parse_checklist(std::string name, std::string value) {
 		|| name == "T3_GB_KERNEL_Y"
 		|| name == "T3_CUTOFF_THRESH"
 		|| name == "T3_DYMASK"
+		|| name == "T3_FIXED_SHIFT"
+		|| name == "T5_WARMUP"
+		|| name == "T5_DYMASK"
+		|| name == "CASCADE"
+		|| name == "DECIMATE"
+		|| name == "DECIMATE_TIER"
+		|| name == "CASCADE_FRAMES"
+		|| name == "CASCADE_PAD"
 		|| name == "T4_AT_BLOCKSIZE"
 		|| name == "T4_GB_KERNEL_X"
 		|| name == "T4_GB_KERNEL_Y"
@@ -1401,6 +3861,50 @@ int parse_checklist(std::string name, std::string value) {
 			CONVERT_FPS = result;
 		} else if (name == "NON_ZERO_START") {
 			NON_ZERO_START = result;
+		} else if (name == "WORKER_THREADS") {
+			WORKER_THREADS = result;
+		} else if (name == "IN_FLIGHT_FRAMES") {
+			IN_FLIGHT_FRAMES = result;
+		} else if (name == "MOTION_GATE_PIXEL") {
+			MOTION_GATE_PIXEL = result;
+		} else if (name == "MOTION_GATE_WARMUP") {
+			MOTION_GATE_WARMUP = result;
+		} else if (name == "MOON_LOST_LIMIT") {
+			MOON_LOST_LIMIT = result;
+		} else if (name == "REACQUIRE_SCALE") {
+			REACQUIRE_SCALE = result;
+		} else if (name == "TILE_SIZE") {
+			TILE_SIZE = result;
+		} else if (name == "TILE_PIXEL") {
+			TILE_PIXEL = result;
+		} else if (name == "TILE_MIN_PIXELS") {
+			TILE_MIN_PIXELS = result;
+		} else if (name == "LOOKBACK_FRAMES") {
+			LOOKBACK_FRAMES = result;
+		} else if (name == "MAX_CONTOURS") {
+			MAX_CONTOURS = result;
+		} else if (name == "CLASSIFY_CHIP") {
+			CLASSIFY_CHIP = std::max(1, result);
+		} else if (name == "CLASSIFY_BATCH") {
+			CLASSIFY_BATCH = result;
+		} else if (name == "LOOKBACK_TIER") {
+			LOOKBACK_TIER = result;
+			if (LOOKBACK_TIER < 1 || LOOKBACK_TIER > 5) {
+				std::cerr << "WARNING: LOOKBACK_TIER must be between 1 and 5, using Tier 1" << std::endl;
+				LOOKBACK_TIER = 1;
+			}
+		} else if (name == "TRACK_TIER") {
+			TRACK_TIER = result;
+			if (TRACK_TIER < 1 || TRACK_TIER > 5) {
+				std::cerr << "WARNING: TRACK_TIER must be between 1 and 5, using Tier 1" << std::endl;
+				TRACK_TIER = 1;
+			}
+		} else if (name == "TRACK_MAX_MISSED") {
+			TRACK_MAX_MISSED = result;
+		} else if (name == "TRACK_MIN_LENGTH") {
+			TRACK_MIN_LENGTH = result;
+		} else if (name == "TRACK_MAX_LENGTH") {
+			TRACK_MAX_LENGTH = result;
 		} else if (name == "T1_AT_BLOCKSIZE") {
 			T1_AT_BLOCKSIZE = result;
 		} else if (name == "T1_DYMASK") {
@@ -1419,6 +3923,26 @@ int parse_checklist(std::string name, std::string value) {
 			T3_CUTOFF_THRESH = result;
 		} else if (name == "T3_DYMASK") {
 			T3_DYMASK = result;
+		} else if (name == "T3_FIXED_SHIFT") {
+			T3_FIXED_SHIFT = result;
+		} else if (name == "T5_WARMUP") {
+			T5_WARMUP = result;
+		} else if (name == "T5_DYMASK") {
+			T5_DYMASK = result;
+		} else if (name == "CASCADE") {
+			CASCADE = result;
+		} else if (name == "DECIMATE") {
+			DECIMATE = result;
+		} else if (name == "DECIMATE_TIER") {
+			DECIMATE_TIER = result;
+			if (DECIMATE_TIER < 1 || DECIMATE_TIER > 4) {
+				std::cerr << "WARNING: DECIMATE_TIER must be between 1 and 4, using Tier 1" << std::endl;
+				DECIMATE_TIER = 1;
+			}
+		} else if (name == "CASCADE_FRAMES") {
+			CASCADE_FRAMES = std::max(0, result);
+		} else if (name == "CASCADE_PAD") {
+			CASCADE_PAD = result;
 		} else if (name == "T4_AT_BLOCKSIZE") {
 			T4_AT_BLOCKSIZE = result;
 		} else if (name == "T4_GB_KERNEL_X") {
@@ -1446,6 +3970,9 @@ int parse_checklist(std::string name, std::string value) {
 		|| name == "T3_LAP_DELTA"
 		|| name == "T3_GB_SIGMA_X"
 		|| name == "T3_GB_SIGMA_Y"
+		|| name == "T3_FIXED_TOLERANCE"
+		|| name == "RECURSIVE_BLUR_TOLERANCE"
+		|| name == "RECURSIVE_BLUR_MEAN_TOLERANCE"
 		|| name == "T4_AT_MAX"
 		|| name == "T4_AT_CONSTANT"
 		|| name == "T4_POWER"
@@ -1453,6 +3980,18 @@ int parse_checklist(std::string name, std::string value) {
 		|| name == "T4_GB_SIGMA_Y"
 		|| name == "QHE_GB_SIGMA_X"
 		|| name == "QHE_GB_SIGMA_Y"
+		|| name == "MOTION_GATE_K"
+		|| name == "MOTION_GATE_ALPHA"
+		|| name == "TRACK_GATE"
+		|| name == "TRACK_MIN_SPEED"
+		|| name == "T5_ALPHA"
+		|| name == "T5_K"
+		|| name == "T5_MIN_SIGMA"
+		|| name == "QUICK_LOOK_STEP"
+		|| name == "QUICK_LOOK_VISIBLE"
+		|| name == "REACQUIRE_FRACTION"
+		|| name == "LOOKBACK_AT_CONSTANT"
+		|| name == "SATURATION_FILL"
 		) {
 		// Store value as relevant double
 		double result = std::stod(value);
@@ -1472,6 +4011,12 @@ int parse_checklist(std::string name, std::string value) {
 			T3_GB_SIGMA_X = result;
 		} else if (name == "T3_GB_SIGMA_Y") {
 			T3_GB_SIGMA_Y = result;
+		} else if (name == "T3_FIXED_TOLERANCE") {
+			T3_FIXED_TOLERANCE = result;
+		} else if (name == "RECURSIVE_BLUR_TOLERANCE") {
+			RECURSIVE_BLUR_TOLERANCE = result;
+		} else if (name == "RECURSIVE_BLUR_MEAN_TOLERANCE") {
+			RECURSIVE_BLUR_MEAN_TOLERANCE = result;
 		} else if (name == "T4_AT_MAX") {
 			T4_AT_MAX = result;
 		} else if (name == "T4_AT_CONSTANT") {
@@ -1486,17 +4031,44 @@ int parse_checklist(std::string name, std::string value) {
 			QHE_GB_SIGMA_X = result;
 		} else if (name == "QHE_GB_SIGMA_Y") {
 			QHE_GB_SIGMA_Y = result;
+		} else if (name == "MOTION_GATE_K") {
+			MOTION_GATE_K = result;
+		} else if (name == "MOTION_GATE_ALPHA") {
+			MOTION_GATE_ALPHA = result;
+		} else if (name == "TRACK_GATE") {
+			TRACK_GATE = result;
+		} else if (name == "TRACK_MIN_SPEED") {
+			TRACK_MIN_SPEED = result;
+		} else if (name == "T5_ALPHA") {
+			T5_ALPHA = result;
+		} else if (name == "T5_K") {
+			T5_K = result;
+		} else if (name == "T5_MIN_SIGMA") {
+			T5_MIN_SIGMA = result;
+		} else if (name == "QUICK_LOOK_STEP") {
+			QUICK_LOOK_STEP = result;
+		} else if (name == "QUICK_LOOK_VISIBLE") {
+			QUICK_LOOK_VISIBLE = result;
+		} else if (name == "REACQUIRE_FRACTION") {
+			REACQUIRE_FRACTION = result;
+		} else if (name == "LOOKBACK_AT_CONSTANT") {
+			LOOKBACK_AT_CONSTANT = result;
+		} else if (name == "SATURATION_FILL") {
+			SATURATION_FILL = result;
 		}
 	} else if (
 		// String cases
 		name == "OSFPROJECT"
 		|| name == "OUTPUTDIR"
+		|| name == "CLASSIFY_MODEL"
 		) {
 			// Store value as appropriate string
 			if (name == "OSFPROJECT") {
 				OSFPROJECT = value;
 			} else if (name == "OUTPUTDIR") {
 				OUTPUTDIR = value;
+			} else if (name == "CLASSIFY_MODEL") {
+				CLASSIFY_MODEL = value;
 			}
 	} else {
 		std::cerr << "Did not recognize entry " << name << " in config file, skipping" << std::endl;
@@ -1544,6 +4116,12 @@ std::string space_space(std::string instring) {
 	tfiles.push_back(TIER2FILE);
 	tfiles.push_back(TIER3FILE);
 	tfiles.push_back(TIER4FILE);
+	if (TIER5) {
+		tfiles.push_back(TIER5FILE);
+	}
+	if (LOOKBACK_FRAMES > 0) {
+		tfiles.push_back(LOOKBACKFILE);
+	}
 	int tcnt = 1;
 	if (DEBUG_COUT) {
 		LOGGING.open(LOGOUT, std::ios_base::app);
@@ -1804,6 +4382,28 @@ static int concat_tiers() {
 		<< std::endl;
 		return 4;
 	}
+	// Open Tier 5 file
+	std::ifstream t5_file;
+	if (TIER5) {
+		t5_file.open(TIER5FILE);
+		if (!t5_file.is_open()) {
+			std::cerr
+			<< "Could not open Tier 5 data"
+			<< std::endl;
+			return 6;
+		}
+	}
+	// Open look-back file
+	std::ifstream lb_file;
+	if (LOOKBACK_FRAMES > 0) {
+		lb_file.open(LOOKBACKFILE);
+		if (!lb_file.is_open()) {
+			std::cerr
+			<< "Could not open look-back data"
+			<< std::endl;
+			return 7;
+		}
+	}
 
 	// Prepare output file
 	std::string mix_loc = OUTPUTDIR + "data/mixed_tiers.csv";
@@ -1822,6 +4422,12 @@ static int concat_tiers() {
 		std::getline(t3_file, line);
 		std::getline(t4_file, line);
 	}
+	if (TIER5 && t5_file.good()) {
+		std::getline(t5_file, line);
+	}
+	if ((LOOKBACK_FRAMES > 0) && lb_file.good()) {
+		std::getline(lb_file, line);
+	}
 
 	// Write column labels for the new file
 	outputfile.open(mix_loc);
@@ -1842,16 +4448,24 @@ static int concat_tiers() {
 	tfiles.push_back(&t2_file);
 	tfiles.push_back(&t3_file);
 	tfiles.push_back(&t4_file);
+	if (TIER5) {
+		tfiles.push_back(&t5_file);
+	}
+	if (LOOKBACK_FRAMES > 0) {
+		tfiles.push_back(&lb_file);
+	}
 	int tcnt = 1;
 	outputfile.open(mix_loc, std::ios_base::app);
 	for (auto i : tfiles) {
+		// Look-back rows are always labeled 6, whether Tier 5 ran or not
+		int label = (i == &lb_file) ? 6 : tcnt;
 		if (DEBUG_COUT) {
 			LOGGING.open(LOGOUT, std::ios_base::app);
-			LOGGING << "Concat begin on file: " << tcnt << std::endl;
+			LOGGING << "Concat begin on file: " << label << std::endl;
 			LOGGING.close();
 		}
 		while (std::getline(*i, line)) {
-			line = line + "," + std::to_string(tcnt);
+			line = line + "," + std::to_string(label);
 			outputfile
 			<< line
 			<< std::endl;
@@ -2023,27 +4637,220 @@ static int post_processing() {
 			<< std::endl;
 		}
 	}
-	if (SIMP_ELL) {
-		if (off_screen_ellipse() != 0) {
-			std::cerr
-			<< "WARNING: Something went wrong simplifying the ellipse screen edges"
-			<< std::endl;
-		}
+	if (SIMP_ELL) {
+		if (off_screen_ellipse() != 0) {
+			std::cerr
+			<< "WARNING: Something went wrong simplifying the ellipse screen edges"
+			<< std::endl;
+		}
+	}
+	return 0;
+}
+
+/**
+ * Get the last n characters of a string.  Handles incorrectly sized searches.
+ * 
+ * @param source Input string
+ * @param length Number of characters from the back to return
+ */
+std::string tail(std::string const& source, size_t const length) {
+	if (length >= source.size()) {
+		return source;
+	}
+	return source.substr(source.size() - length);
+}
+
+/**
+ * Creates the data files of a full run, each holding only its header line.  Files of features which
+ * are switched off are not created.
+ */
+static void write_headers() {
+	std::ofstream outfile;
+	outfile.open(TIER1FILE);
+	outfile
+	<< "frame number"
+	<< ","
+	<< "x pos"
+	<< ","
+	<< "y pos"
+	<< ","
+	<< "radius"
+	<< std::endl;
+	outfile.close();
+	outfile.open(TIER2FILE);
+	outfile
+	<< "frame number"
+	<< ","
+	<< "x pos"
+	<< ","
+	<< "y pos"
+	<< ","
+	<< "radius"
+	<< std::endl;
+	outfile.close();
+	outfile.open(TIER3FILE);
+	outfile
+	<< "frame number"
+	<< ","
+	<< "x pos"
+	<< ","
+	<< "y pos"
+	<< ","
+	<< "radius"
+	<< std::endl;
+	outfile.close();
+	outfile.open(TIER4FILE);
+	outfile
+	<< "frame number"
+	<< ","
+	<< "x pos"
+	<< ","
+	<< "y pos"
+	<< ","
+	<< "radius"
+	<< std::endl;
+	outfile.close();
+	if (TIER5) {
+		outfile.open(TIER5FILE);
+		outfile
+		<< "frame number"
+		<< ","
+		<< "x pos"
+		<< ","
+		<< "y pos"
+		<< ","
+		<< "radius"
+		<< std::endl;
+		outfile.close();
+	}
+	if (LOOKBACK_FRAMES > 0) {
+		outfile.open(LOOKBACKFILE);
+		outfile
+		<< "frame number"
+		<< ","
+		<< "x pos"
+		<< ","
+		<< "y pos"
+		<< ","
+		<< "radius"
+		<< std::endl;
+		outfile.close();
+	}
+
+	// Touch output saturated frame file
+	outfile.open(SATURATEDDATA);
+	outfile
+	<< "frame number"
+	<< ","
+	<< "tier"
+	<< ","
+	<< "contours"
+	<< ","
+	<< "fill"
+	<< std::endl;
+	outfile.close();
+
+	// Touch output classifier file
+	if (CLASSIFY) {
+		outfile.open(CLASSDATA);
+		outfile
+		<< "frame number"
+		<< ","
+		<< "tier"
+		<< ","
+		<< "x pos"
+		<< ","
+		<< "y pos"
+		<< ","
+		<< "radius"
+		<< ","
+		<< "score"
+		<< std::endl;
+		outfile.close();
+	}
+
+	// Touch output motion gate file
+	if (MOTION_GATE) {
+		outfile.open(GATEDATA);
+		outfile
+		<< "frame number"
+		<< ","
+		<< "change energy"
+		<< ","
+		<< "noise floor"
+		<< ","
+		<< "limit"
+		<< ","
+		<< "skipped"
+		<< std::endl;
+		outfile.close();
 	}
-	return 0;
-}
 
-/**
- * Get the last n characters of a string.  Handles incorrectly sized searches.
- * 
- * @param source Input string
- * @param length Number of characters from the back to return
- */
-std::string tail(std::string const& source, size_t const length) {
-	if (length >= source.size()) {
-		return source;
+	// Touch output track file
+	if (TRACKING) {
+		outfile.open(TRACKDATA);
+		outfile
+		<< "track"
+		<< ","
+		<< "start frame"
+		<< ","
+		<< "end frame"
+		<< ","
+		<< "detections"
+		<< ","
+		<< "start x"
+		<< ","
+		<< "start y"
+		<< ","
+		<< "end x"
+		<< ","
+		<< "end y"
+		<< ","
+		<< "speed"
+		<< ","
+		<< "path"
+		<< std::endl;
+		outfile.close();
 	}
-	return source.substr(source.size() - length);
+
+	// Touch output moon lost file
+	outfile.open(MOONLOSTDATA);
+	outfile
+	<< "first frame"
+	<< ","
+	<< "last frame"
+	<< ","
+	<< "frames lost"
+	<< ","
+	<< "reacquired"
+	<< std::endl;
+	outfile.close();
+
+	// Touch output ellipse file
+	std::ofstream outell;
+	outell.open(ELLIPSEDATA);
+	outell
+	<< "frame number"
+	<< ","
+	<< "moon center x"
+	<< ","
+	<< "moon center y"
+	<< ","
+	<< "moon x diameter"
+	<< ","
+	<< "moon y diameter"
+	<< ","
+	<< "moon enclosing box area"
+	<< ","
+	<< "points on top edge"
+	<< ","
+	<< "points on bot edge"
+	<< ","
+	<< "points on left edge"
+	<< ","
+	<< "points on right edge"
+	<< std::endl;
+	outell.close();
 }
 
 /**
@@ -2054,8 +4861,7 @@ std::string tail(std::string const& source, size_t const length) {
  * @return status
  */
 int main(int argc, char* argv[]) {
-	// Capture interrupt signals so we don't create zombie processes
-	// FIXME This doesn't work right with all the forks.
+	// Capture interrupt signals so the worker threads can be stopped cleanly
 	signal(SIGINT, signal_callback_handler);
 
 	// Arg Handler --------------------------------------------------------------------------------
@@ -2070,6 +4876,8 @@ int main(int argc, char* argv[]) {
 	std::string osf_file = "";
 	std::string input_file = "";
 	std::string config_file = "settings.cfg";
+	bool quick = false;
+	bool self_test = false;
 
 	for (int i = 1; i < argc; ++i) {
 		string arg = argv[i];
@@ -2090,6 +4898,10 @@ int main(int argc, char* argv[]) {
 			<< "Wesley T. Honeycutt, Oklahoma Biological Survey"
 			<< std::endl;
 			return 0;
+		} else if ((arg == "-q") || (arg == "--quick-look")) {
+			quick = true;
+		} else if ((arg == "-t") || (arg == "--self-test")) {
+			self_test = true;
 		} else if ((arg == "-c") || (arg == "--config-file")) {
 			if (i + 1 < argc) {
 				config_file = argv[++i];
@@ -2124,7 +4936,7 @@ int main(int argc, char* argv[]) {
 	if (osf_file.length() > 0 && input_file.length() > 0) {
 		std::cerr << "Either use an input file or an OSF file, not both" << std::endl;
 		return 1;
-	} else if (osf_file.length() == 0 && input_file.length() == 0) {
+	} else if (osf_file.length() == 0 && input_file.length() == 0 && !self_test) {
 		std::cerr << "You must give frame_extraction an input file or an OSF path" << std::endl;
 		return 1;
 	} else if (osf_file.length() > 0) {
@@ -2190,7 +5002,24 @@ int main(int argc, char* argv[]) {
 		LOGGING.open(LOGOUT);
 		LOGGING.close();
 	}
-	if (OUTPUT_FRAMES) {
+	if (select_kernels(self_test)) {
+		std::cerr << "An approximate kernel is out of tolerance, see the warnings above" << std::endl;
+		return 1;
+	}
+	if (self_test) {
+		std::string model = CLASSIFY_MODEL.empty() ? "models/classifier_stand_in.onnx" : CLASSIFY_MODEL;
+		if (CLASSIFIER.load(model) || CLASSIFIER.check()) {
+			std::cerr << "The classifier check failed, see the warnings above" << std::endl;
+			return 1;
+		}
+		std::cout << "Self test passed" << std::endl;
+		return 0;
+	}
+	if (CLASSIFY && (CLASSIFIER.load(CLASSIFY_MODEL) || CLASSIFIER.check())) {
+		std::cerr << "WARNING: Running without the classifier" << std::endl;
+		CLASSIFY = false;
+	}
+	if (OUTPUT_FRAMES && !quick) {
 		localpath = OUTPUTDIR + "frames";
 		fs::create_directories(localpath);
 	}
@@ -2200,82 +5029,23 @@ int main(int argc, char* argv[]) {
 	TIER2FILE = OUTPUTDIR + "data/Tier2.csv";
 	TIER3FILE = OUTPUTDIR + "data/Tier3.csv";
 	TIER4FILE = OUTPUTDIR + "data/Tier4.csv";
+	TIER5FILE = OUTPUTDIR + "data/Tier5.csv";
+	LOOKBACKFILE = OUTPUTDIR + "data/LookBack.csv";
+	CLASSDATA = OUTPUTDIR + "data/classified.csv";
+	SATURATEDDATA = OUTPUTDIR + "data/saturated.csv";
 	ELLIPSEDATA = OUTPUTDIR + "data/ellipses.csv";
 	METADATA = OUTPUTDIR + "data/metadata.csv";
+	GATEDATA = OUTPUTDIR + "data/gating.csv";
+	TRACKDATA = OUTPUTDIR + "data/tracks.csv";
+	QUICKDATA = OUTPUTDIR + "data/quicklook.csv";
+	MOONLOSTDATA = OUTPUTDIR + "data/moonlost.csv";
 	if (OUTPUT_FRAMES && TIGHT_CROP) {
 		BOXDATA = OUTPUTDIR + "data/boxes.csv";
 	}
 
-	outfile.open(TIER1FILE);
-	outfile
-	<< "frame number"
-	<< ","
-	<< "x pos"
-	<< ","
-	<< "y pos"
-	<< ","
-	<< "radius"
-	<< std::endl;
-	outfile.close();
-	outfile.open(TIER2FILE);
-	outfile
-	<< "frame number"
-	<< ","
-	<< "x pos"
-	<< ","
-	<< "y pos"
-	<< ","
-	<< "radius"
-	<< std::endl;
-	outfile.close();
-	outfile.open(TIER3FILE);
-	outfile
-	<< "frame number"
-	<< ","
-	<< "x pos"
-	<< ","
-	<< "y pos"
-	<< ","
-	<< "radius"
-	<< std::endl;
-	outfile.close();
-	outfile.open(TIER4FILE);
-	outfile
-	<< "frame number"
-	<< ","
-	<< "x pos"
-	<< ","
-	<< "y pos"
-	<< ","
-	<< "radius"
-	<< std::endl;
-	outfile.close();
-
-	// Touch output ellipse file
-	std::ofstream outell;
-	outell.open(ELLIPSEDATA);
-	outell
-	<< "frame number"
-	<< ","
-	<< "moon center x"
-	<< ","
-	<< "moon center y"
-	<< ","
-	<< "moon x diameter"
-	<< ","
-	<< "moon y diameter"
-	<< ","
-	<< "moon enclosing box area"
-	<< ","
-	<< "points on top edge"
-	<< ","
-	<< "points on bot edge"
-	<< ","
-	<< "points on left edge"
-	<< ","
-	<< "points on right edge"
-	<< std::endl;
-	outell.close();
+	if (!quick) {
+		write_headers();
+	}
 	
 	// Import OSF file ----------------------------------------------------------------------------
 	
@@ -2453,7 +5223,7 @@ int main(int argc, char* argv[]) {
 	// Done with the metadata
 	metafile.close();
 
-	if (OUTPUT_FRAMES && TIGHT_CROP) {
+	if (OUTPUT_FRAMES && TIGHT_CROP && !quick) {
 		outfile.open(BOXDATA);
 		outfile
 		<< "frame number"
@@ -2480,42 +5250,12 @@ int main(int argc, char* argv[]) {
 	}
 
 	// Instance and Assign ------------------------------------------------------------------------
-	// Memory map variables we want to share across forks
-	// mm_gotframe reports that the frame acquisition was completed
-	// mm_gotconts reports that video processing was completed
-	// mm_localfrm reports that the current frame was grabbed, proceed getting next frame
-	// mm_ranprocs reports that the contours were recorded
-	// mm_frmcount stores the frame counter
-	auto *mm_killed = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_frameavail = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_gotframe1 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_gotframe2 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_gotframe3 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_tier1 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_tier2 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_tier3 = static_cast <bool *>(mmap(NULL, sizeof(bool), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	auto *mm_frmcount = static_cast <int *>(mmap(NULL, sizeof(int), \
-		PROT_READ|PROT_WRITE, MAP_SHARED|MAP_ANONYMOUS, -1, 0));
-	*mm_frmcount = -1;
+	// framecnt stores the frame counter
+	int framecnt = -1;
 
 	// OpenCV specific variables
 	Mat frame;
 
-	// Memory and fork management inits
-	int frame_fd = open("/tmp/file", O_CREAT|O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-	int frame_fd2 = open("/tmp/file2", O_CREAT|O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IWGRP);
-
-	// Other local variables
-	int thresh = 0;
-
 
 	// Tell OpenCV to open our video and fetch the first frame ------------------------------------
 	VideoCapture cap(input_file); // open the default camera
@@ -2535,10 +5275,10 @@ int main(int argc, char* argv[]) {
 			return -1;
 		}
 		Mat temp_frame;
-		++*mm_frmcount;
+		++framecnt;
 		cvtColor(frame.clone(), frame, COLOR_BGR2GRAY);
 		threshold(frame.clone(), temp_frame, BLACKOUT_THRESH, 255, THRESH_TOZERO);
-		vector <vector<Point>> contours = contours_only(temp_frame);
+		ContourSet contours = contours_only(temp_frame, CHAIN_APPROX_SIMPLE);
 		int largest = largest_contour(contours);
 		int val = touching_edges(frame, contours[largest]);
 		if (val == 0) {
@@ -2547,35 +5287,57 @@ int main(int argc, char* argv[]) {
 	}
 
 	// Process this frame to establish initial values
-	first_frame(frame.clone(), *mm_frmcount);
+	first_frame(frame.clone(), framecnt);
 	if (DEBUG_COUT) {
 		LOGGING.open(LOGOUT, std::ios_base::app);
-		LOGGING << "passed first frame, used frame " << *mm_frmcount << " as corners" << std::endl;
+		LOGGING << "passed first frame, used frame " << framecnt << " as corners" << std::endl;
 		LOGGING.close();
 	}
 	// Release and restart the video from the beginning.
 	cap.release();
-	*mm_frmcount = -1;
+
+	if (quick) {
+		if (quick_look(input_file) != 0) {
+			std::cerr
+			<< "Exiting frame_extraction with errors"
+			<< std::endl;
+			return 1;
+		}
+		return 0;
+	}
+	framecnt = -1;
 	cap.open(input_file);
 	if (!cap.isOpened())  // check if we succeeded
 		return -1;
 
 	// Get the first frame
 	cap >> frame;
-	++*mm_frmcount;
+	++framecnt;
 
-	// DEBUG Skip frames for debugging
-	while (*mm_frmcount < NON_ZERO_START) {
-		++*mm_frmcount;
+	// DEBUG Skip frames for debugging, jumping straight to the last keyframe before the start
+	if (KEYFRAME_INDEX && (NON_ZERO_START > framecnt)) {
+		load_keyframe_index(input_file);
+	}
+	int start_key = nearest_keyframe(NON_ZERO_START, false);
+	if (start_key > framecnt) {
+		cap.set(CAP_PROP_POS_FRAMES, start_key);
+		cap >> frame;
+		framecnt = start_key;
+	}
+	while (framecnt < NON_ZERO_START) {
+		++framecnt;
 		cap >> frame;
 	}
 
 	cvtColor(frame, frame, COLOR_BGR2GRAY);
-	halo_noise_and_center(frame.clone(), *mm_frmcount);
+	halo_noise_and_center(frame.clone(), framecnt);
 	frame = HNC_FRAME;
+	// Size of the moon used to decide when it is found again after being lost
+	int moon_area = BF_BOX.area();
+	int lost_since = -1;
 
 	if (OUTPUT_FRAMES) {
-		std::string output_loc = out_frame_gen(*mm_frmcount);
+		std::string output_loc = out_frame_gen(framecnt);
 		imwrite(output_loc, frame);
 		if (DEBUG_COUT) {
 			LOGGING.open(LOGOUT, std::ios_base::app);
@@ -2584,226 +5346,186 @@ int main(int argc, char* argv[]) {
 		}
 	}
 
-	// Memory management init continued -----------------------------------------------------------
-	// Memory map slot for video frame
-	// This must be called after the first test frame so we have the correct size info
-	// e.g. we expect 6220800 bytes for a 3 channel 1920x1080 image
-	const size_t shmem_size = frame.total() * frame.elemSize();
+	// The last centered frames, the first one only serves as the old_frame of the next one
+	FrameHistory history(DOUBLE_DIFFERENCE ? 3 : 2);
+	history.push(frame);
 
+	// Start the worker threads which run the Tiers
+	std::unique_ptr<TaskPool> pool(new TaskPool(WORKER_THREADS));
 	if (DEBUG_COUT) {
 		LOGGING.open(LOGOUT, std::ios_base::app);
-		LOGGING
-		<< "frame dimensions: "
-		<< frame.size().width
-		<< " x "
-		<< frame.size().height
-		<< " x "
-		<< frame.elemSize()
-		<< " = "
-		<< shmem_size
-		<< std::endl
-		<< "frame_fd: "
-		<< frame_fd
-		<< std::endl;
+		LOGGING << "Started task pool with " << pool->size() << " worker threads" << std::endl;
 		LOGGING.close();
 	}
-
-	// Resize the frame_fd to fit the frame size we are using
-	if (ftruncate(frame_fd, shmem_size) != 0) {
-		std::cerr << "failed to truncate resize file descriptor" << std::endl;
-		return 1;
-	}
-	// Resize the frame_fd to fit the frame size we are using
-	if (ftruncate(frame_fd2, shmem_size) != 0) {
-		std::cerr << "failed to truncate resize file descriptor 2" << std::endl;
-		return 1;
-	}
-
-
-	unsigned char *buf = static_cast <unsigned char*>(mmap(NULL, shmem_size, PROT_READ|PROT_WRITE, MAP_SHARED, frame_fd, 0));
-	memcpy(buf, frame.ptr(), shmem_size);
-	if (DEBUG_COUT) {
-		LOGGING.open(LOGOUT, std::ios_base::app);
-		LOGGING << "memcpy'd buf1 with size:" << sizeof(*buf) << std::endl;
-		LOGGING.close();
+	// Frames may finish out of order, the reorder buffer writes them to the Tier files in order
+	ReorderBuffer committer(commit_frame);
+	if (LOOKBACK_FRAMES > 0) {
+		LOOKBACK.start(*pool);
 	}
-
-	unsigned char *buf2 = static_cast <unsigned char*>(mmap(NULL, shmem_size, PROT_READ|PROT_WRITE, MAP_SHARED, frame_fd2, 0));
-	memcpy(buf2, frame.ptr(), shmem_size);
-	if (DEBUG_COUT) {
-		LOGGING.open(LOGOUT, std::ios_base::app);
-		LOGGING << "memcpy'd buf2 with size:"  << sizeof(*buf2) << std::endl;
-		LOGGING.close();
+	if (CLASSIFY) {
+		CLASSIFIER.start(*pool);
 	}
-
-	// Store first frame in memory
-	memcpy(buf, frame.ptr(), shmem_size);
-	*mm_frameavail = true;
-
-	// Delared PID here so we can stash the fork in an if statement.
-	int pid0;
-	int pid1;
-	int pid2;
-
-	// Set all the mm_ codes
-	*mm_killed = false;
-	*mm_frameavail = true;
-	*mm_tier1 = true;
-	*mm_tier2 = true;
-	*mm_tier3 = true;
+	std::deque<std::shared_ptr<TaskGraph>> in_flight;
+	int sequence = 0;
+	Cascade cascade;
+	Decimator decimator;
+	// Waits for the oldest frame's graph when the pipeline is full, then launches the next one
+	auto submit = [&in_flight, &pool](std::shared_ptr<TaskGraph> graph) {
+		while (static_cast<int>(in_flight.size()) >= std::max(1, IN_FLIGHT_FRAMES)) {
+			in_flight.front()->wait();
+			in_flight.pop_front();
+		}
+		in_flight.push_back(graph);
+		graph->launch(*pool);
+	};
 
 	// Main Loop ----------------------------------------------------------------------------------
-	pid0 = fork();
-
-	if (pid0 > 0) {
-		// FORK 0 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-		while (cap.isOpened()) {
-			// Check for ctrl C
-			if (SIG_ALERT != 0) {
-				*mm_killed = true;
-				cap.release();
-				break;
-			}
-			while ((*mm_tier1 == false) || (*mm_tier2 == false) || (*mm_tier3 == false)) {
-				usleep(50);
-			}
-			*mm_frameavail = false;
-			*mm_tier1 = false;
-			*mm_tier2 = false;
-			*mm_tier3 = false;
+	// This thread decodes and centers the next frame while the workers run the task graphs of up to
+	// IN_FLIGHT_FRAMES earlier frames.
+	while (cap.isOpened()) {
+		// Check for ctrl C
+		if (SIG_ALERT != 0) {
+			cap.release();
+			break;
+		}
 
+		// Get new frame; operate and store
+		cap >> frame;
+		if (frame.empty()) {
+			LOGGING.open(LOGOUT, std::ios_base::app);
+			LOGGING << "Reached end of frames.  Exiting" << std::endl;
+			LOGGING.close();
+			break;
+		}
+		++framecnt;
 
-			// Cycle ring buffer
-			memcpy(buf2, buf, shmem_size);
-			// Get new frame; operate and store
-			cap >> frame;
-			if (frame.empty()) {
-				LOGGING.open(LOGOUT, std::ios_base::app);
-				LOGGING << "Reached end of frames.  Exiting" << std::endl;
-				LOGGING.close();
-				break;
-			}
-			++*mm_frmcount;
+		if (DEBUG_COUT) {
+			LOGGING.open(LOGOUT, std::ios_base::app);
+			LOGGING
+			<< "----------------------- frame number: "
+			<< framecnt
+			<< std::endl;
+			LOGGING.close();
+		}
 
-			if (DEBUG_COUT) {
-				LOGGING.open(LOGOUT, std::ios_base::app);
-				LOGGING
-				<< "----------------------- frame number: "
-				<< *mm_frmcount
-				<< std::endl;
-				LOGGING.close();
+		// Image processing operations
+		cvtColor(frame, frame, COLOR_BGR2GRAY);
+		// While the moon is lost only the low resolution scan runs until it looks visible again
+		bool centered = (lost_since < 0) || moon_reacquired(frame, moon_area);
+		if (centered && halo_noise_and_center(frame.clone(), framecnt)) {
+			centered = false;
+		}
+		if (!centered) {
+			if (lost_since < 0) {
+				lost_since = framecnt;
+				std::cerr << "WARNING: Lost the moon at frame " << framecnt << ", skipping frames until it is"
+				<< " found again" << std::endl;
 			}
-
-			// Image processing operations
-			cvtColor(frame, frame, COLOR_BGR2GRAY);
-			if (halo_noise_and_center(frame.clone(), *mm_frmcount)) {
-				std::cerr << "ERROR: Encountered empty frame.  Ending this run.  "
-				<< "If you believe the moon is refound later in the video, break video into parts"
-				<< " and re-run each part" << std::endl;
-				*mm_killed = true;
+			if ((MOON_LOST_LIMIT > 0) && (framecnt - lost_since + 1 >= MOON_LOST_LIMIT)) {
+				std::cerr << "ERROR: Moon lost for " << MOON_LOST_LIMIT << " frames.  Ending this run."
+				<< std::endl;
+				moon_lost_data(lost_since, framecnt, false);
+				lost_since = -1;
 				cap.release();
 				break;
 			}
-			frame = HNC_FRAME;
+			continue;
+		}
+		frame = HNC_FRAME;
+		bool reacquired = (lost_since >= 0);
+		if (reacquired) {
+			moon_lost_data(lost_since, framecnt - 1, true);
+			lost_since = -1;
+		}
+		if (DEBUG_COUT) {
+			LOGGING.open(LOGOUT, std::ios_base::app);
+			LOGGING
+			<< "frame dimensions: "
+			<< frame.size().width
+			<< " x "
+			<< frame.size().height
+			<< " x "
+			<< frame.elemSize()
+			<< std::endl;
+			LOGGING.close();
+		}
+
+		if (OUTPUT_FRAMES) {
+			std::string output_loc = out_frame_gen(framecnt);
+			imwrite(output_loc, frame);
 			if (DEBUG_COUT) {
 				LOGGING.open(LOGOUT, std::ios_base::app);
-				LOGGING
-				<< "frame dimensions: "
-				<< frame.size().width
-				<< " x "
-				<< frame.size().height
-				<< " x "
-				<< frame.elemSize()
-				<< " = "
-				<< shmem_size
-				<< std::endl;
+				LOGGING << "frame saved at " << output_loc << std::endl;
 				LOGGING.close();
 			}
-			// Store this image into the memory buffer
-			memcpy(buf, frame.ptr(), shmem_size);
-
-			// Report that the frame was stored
-			*mm_frameavail = true;
-
-			if (OUTPUT_FRAMES) {
-				std::string output_loc = out_frame_gen(*mm_frmcount);
-				imwrite(output_loc, frame);
-				if (DEBUG_COUT) {
-					LOGGING.open(LOGOUT, std::ios_base::app);
-					LOGGING << "frame saved at " << output_loc << std::endl;
-					LOGGING.close();
-				}
-			}
+		}
 
-			if (DEBUG_FRAMES) {
-				imshow("fg_mask", frame);
-				waitKey(1);
-			}
+		if (DEBUG_FRAMES) {
+			imshow("fg_mask", frame);
+			waitKey(1);
 		}
-		*mm_killed = true;
-	} else {
-		pid1 = fork();
-		if (pid1 > 0) {
-			// FORK 1 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-			while (*mm_killed == false) {
-				while ((*mm_frameavail == false) || (*mm_tier1 == true) || (*mm_tier2 == true) || (*mm_tier3 == true)) {
-					usleep(50);
-				}
-				// Grab the frame and store it locally
-				Mat local_frame = cv::Mat(Size(frame.size().width, frame.size().height), CV_8UC1, buf, 1 * frame.size().width);
-				Mat local_frame_1 = local_frame.clone();
-				Mat local_frame_2 = local_frame.clone();
-				int local_count = *mm_frmcount;
-				vector <Point> bigone = qhe_bigone(local_frame);
-				if ((bigone[0].x < 0) && (bigone[0].y < 0)) {
-						std::cerr
-						<< "WARNING: largest frame returned error, beware T1 and T2 for frame: "
-						<< local_count
-						<< std::endl;
-					}
-				tier_one(local_count, local_frame_1.clone(), bigone);
-				tier_two(local_count, local_frame_2.clone(), bigone);
-				*mm_tier1 = true;
-				*mm_tier2 = true;
-			}
-		} else {
-			// FORK 2 +++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++++
-			while (*mm_killed == false) {
-				while ((*mm_frameavail == false) || (*mm_tier1 == true) || (*mm_tier2 == true) || (*mm_tier3 == true))  {
-					usleep(50);
-				}
-				int local_count = *mm_frmcount;
-				if (local_count == 0) {
-					// Skip the zeroth frame since there will be no old_frame
-					if (DEBUG_COUT) {
-						LOGGING.open(LOGOUT, std::ios_base::app);
-						LOGGING
-						<< "skipping early frame tier3 in frame: "
-						<< local_count
-						<< std::endl;
-						LOGGING.close();
-					}
-				} else {
 
-					// Grab the previous frame + current frame and store them locally
-					Mat local_frame = cv::Mat(Size(frame.size().width, frame.size().height), CV_8UC1, buf, 1 * frame.size().width);
-					Mat oldframe = cv::Mat(Size(frame.size().width, frame.size().height), CV_8UC1, buf2, 1 * frame.size().width);
-					vector <Point> bigone = qhe_bigone(local_frame);
-					if ((bigone[0].x < 0) && (bigone[0].y < 0)) {
-						std::cerr
-						<< "WARNING: largest frame returned error, beware T3 and T4 for frame: "
-						<< local_count
-						<< std::endl;
-					}
-					tier_three(local_count, local_frame.clone(), oldframe.clone(), bigone);
-					tier_four(local_count, local_frame.clone(), oldframe.clone(), bigone);
-					*mm_tier3 = true;
-				}
+		// The first frame after the moon is found again has no usable old_frame
+		if (reacquired) {
+			history.clear();
+			history.push(frame);
+			continue;
+		}
+		history.push(frame);
+
+		auto job = std::make_shared<FrameJob>();
+		job->sequence = sequence++;
+		job->framecnt = framecnt;
+		job->frame = frame;
+		job->old_frame = history.back(1);
+		job->older_frame = history.back(2);
+		job->skip_tiers = MOTION_GATE && motion_gate(framecnt, frame, job->old_frame);
+		job->skip_expensive = false;
+		if (DECIMATE > 1) {
+			// Only every DECIMATE frames runs now, the frames between wait to see if a bird was found
+			std::shared_ptr<TaskGraph> graph;
+			if (decimator.sampled()) {
+				graph = frame_graph(job, committer, STAGE_ALL);
+				submit(graph);
 			}
-
+			decimator.add(job, graph);
+			while (auto ready = decimator.next(false)) {
+				submit(frame_graph(ready, committer, STAGE_ALL));
+			}
+		} else if (CASCADE > 0) {
+			// Tiers 3 and 4 wait for the cascade to see the Tier 1 and 2 results around the frame
+			auto cheap = frame_graph(job, committer, STAGE_CHEAP);
+			cheap->launch(*pool);
+			cascade.add(job, cheap);
+			while (auto ready = cascade.next(false)) {
+				submit(frame_graph(ready, committer, STAGE_EXPENSIVE));
+			}
+		} else {
+			submit(frame_graph(job, committer, STAGE_ALL));
 		}
 	}
- 	usleep(1000000);
+	if (lost_since >= 0) {
+		moon_lost_data(lost_since, framecnt, false);
+	}
+	while (auto ready = decimator.next(true)) {
+		submit(frame_graph(ready, committer, STAGE_ALL));
+	}
+	while (auto ready = cascade.next(true)) {
+		submit(frame_graph(ready, committer, STAGE_EXPENSIVE));
+	}
+	for (auto &graph : in_flight) {
+		graph->wait();
+	}
+	if (LOOKBACK_FRAMES > 0) {
+		LOOKBACK.finish();
+	}
+	if (CLASSIFY) {
+		CLASSIFIER.finish();
+	}
+	pool.reset();
+	if (TRACKING) {
+		TRACKER.finish();
+	}
 
 	BOXSIZE = 1080;
 	if (post_processing() != 0) {
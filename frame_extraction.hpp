@@ -22,12 +22,20 @@
 
 // Includes
 #include <algorithm>
+#include <atomic>                        // for atomic
+#include <condition_variable>            // for condition_variable
+#include <cstdio>                        // for popen
 #include <ctime>                         // for NULL
+#include <deque>                         // for deque
 #include <errno.h>
 #include <tgmath.h>                      // for sin, cos, etc.
 #include <fcntl.h>
 #include <fstream>
+#include <functional>                    // for function
 #include <iostream>
+#include <map>                           // for map
+#include <memory>                        // for shared_ptr
+#include <mutex>                         // for mutex, lock_guard
 #include <numeric>                       // for accumulate
 #include <pthread.h>
 #include <signal.h>
@@ -36,6 +44,7 @@
 #include <sys/shm.h>                     // for shmat
 #include <sys/mman.h>                    // for MAP_ANONYMOUS, MAP_SHARED
 #include <sys/wait.h>
+#include <thread>                        // for thread
 #include <tuple>
 #include <unistd.h>                      // for fork, sleep, usleep
 #include <typeinfo>
@@ -51,6 +60,7 @@ namespace fs = std::experimental::filesystem;
 using std::vector;
 
 #include "opencv2/opencv.hpp"
+#include "opencv2/dnn.hpp"
 #include "opencv2/ximgproc.hpp"
 using namespace cv;
 
@@ -109,9 +119,10 @@ Point ORIG_BR;
  */
 std::string LOGOUT;
 /**
- * Holder for the output stream created by DEBUG_COUT functions.
+ * Holder for the output stream created by DEBUG_COUT functions.  Each worker thread keeps its own
+ * stream, so log lines from concurrent Tiers are appended to LOGOUT without sharing a buffer.
  */
-std::ofstream LOGGING;
+thread_local std::ofstream LOGGING;
 /**
  * Holder for the location of the Tier 1 data output CSV
  */
@@ -128,6 +139,22 @@ std::string TIER3FILE;
  * Holder for the location of the Tier 4 data output CSV
  */
 std::string TIER4FILE;
+/**
+ * Holder for the location of the Tier 5 data output CSV
+ */
+std::string TIER5FILE;
+/**
+ * Holder for the location of the look-back data output CSV
+ */
+std::string LOOKBACKFILE;
+/**
+ * Holder for the location of the classifier score output CSV
+ */
+std::string CLASSDATA;
+/**
+ * Holder for the location of the saturated frame output CSV
+ */
+std::string SATURATEDDATA;
 /**
  * Holder for the location of the ellipse data output CSV
  */
@@ -140,6 +167,22 @@ std::string BOXDATA;
  * Holder for the location of the metadata file
  */
 std::string METADATA;
+/**
+ * Holder for the location of the motion gate decision output CSV
+ */
+std::string GATEDATA;
+/**
+ * Holder for the location of the track output CSV
+ */
+std::string TRACKDATA;
+/**
+ * Holder for the location of the quick look output CSV
+ */
+std::string QUICKDATA;
+/**
+ * Holder for the location of the moon lost output CSV
+ */
+std::string MOONLOSTDATA;
 /**
  * Calcualted width to use for tight cropping
  */
@@ -153,6 +196,18 @@ int TC_H;
  * large frame, indicating the moon has vanished.
  */
 bool CAUGHT_EMPTY = false;
+/**
+ * Running mean of the motion gate change energy, the noise floor used by motion_gate()
+ */
+double GATE_FLOOR_MEAN = 0;
+/**
+ * Running variance of the motion gate change energy, used by motion_gate()
+ */
+double GATE_FLOOR_VAR = 0;
+/**
+ * Number of frames measured by motion_gate() so far
+ */
+int GATE_FRAMES = 0;
 
 
 
@@ -211,6 +266,65 @@ bool SIMP_ELL = true;
  * User configurable from settings.cfg
  */
 bool CONCAT_TIERS = true;
+/**
+ * Use the older per contour minEnclosingCircle output for the Tiers instead of blob statistics?
+ * User configurable from settings.cfg
+ */
+bool CONTOUR_TIERS = false;
+/**
+ * Should Tiers 3 and 4 difference against frames n-1 and n-2 instead of only n-1?
+ * User configurable from settings.cfg
+ */
+bool DOUBLE_DIFFERENCE = false;
+/**
+ * Number of frames before a detection rescanned with the sensitive look-back settings.  0 turns the
+ * look-back off.
+ * User configurable from settings.cfg
+ */
+int LOOKBACK_FRAMES = 0;
+/**
+ * Tier whose detections trigger the look-back rescan
+ * User configurable from settings.cfg
+ */
+int LOOKBACK_TIER = 1;
+/**
+ * Subtracted constant for the Tier 2 style adaptive threshold of the look-back rescan.
+ * User configurable from settings.cfg
+ */
+double LOOKBACK_AT_CONSTANT = 10;
+/**
+ * Score the Tier detections with a classifier model?
+ * User configurable from settings.cfg
+ */
+bool CLASSIFY = false;
+/**
+ * Location of the classifier model (e.g. an ONNX file)
+ * User configurable from settings.cfg
+ */
+std::string CLASSIFY_MODEL = "";
+/**
+ * Width and height of the chip cropped around each detection for the classifier
+ * User configurable from settings.cfg
+ */
+int CLASSIFY_CHIP = 32;
+/**
+ * Number of chips the classifier runs on at once
+ * User configurable from settings.cfg
+ */
+int CLASSIFY_BATCH = 64;
+/**
+ * Most contours (or blobs) a Tier may find on a frame before the frame counts as saturated.  0 for no
+ * limit.  The default is twice the most the look-back rescan, the most sensitive Tier, finds on a
+ * clear frame, so only clouds and haze reach it (see saturated.csv in the README).
+ * User configurable from settings.cfg
+ */
+int MAX_CONTOURS = 20000;
+/**
+ * Largest fraction of a Tier's mask, after the dynamic mask, which may be set before the frame counts
+ * as saturated.  0 for no limit.  The default is five times the most a clear frame fills.
+ * User configurable from settings.cfg
+ */
+double SATURATION_FILL = 0.5;
 /**
  * Tight crop the output frames when generating the slideshow?
  * This is ignored if OUTPUT_FRAMES = false
@@ -260,6 +374,177 @@ int CONVERT_FPS = 30;
  * User configurable from settings.cfg
  */
 int NON_ZERO_START = 0;
+/**
+ * Number of worker threads used to run the Tier task graph.  Zero uses one thread per CPU core.
+ * User configurable from settings.cfg
+ */
+int WORKER_THREADS = 0;
+/**
+ * Use the recursive (IIR) Gaussian blur, whose cost does not depend on the kernel size, for every blur?
+ * User configurable from settings.cfg
+ */
+bool RECURSIVE_BLUR = false;
+/**
+ * Largest difference in 8-bit levels allowed between the recursive blur and GaussianBlur on any
+ * pixel of the test image.
+ * User configurable from settings.cfg
+ */
+double RECURSIVE_BLUR_TOLERANCE = 10;
+/**
+ * Largest mean difference in 8-bit levels allowed between the recursive blur and GaussianBlur over
+ * the test image.
+ * User configurable from settings.cfg
+ */
+double RECURSIVE_BLUR_MEAN_TOLERANCE = 0.4;
+/**
+ * Number of frames which may be in the task graph at the same time.  Rows are still written to the
+ * Tier files in frame order.  One frame in flight matches the older lock-step behavior.
+ * User configurable from settings.cfg
+ */
+int IN_FLIGHT_FRAMES = 1;
+/**
+ * Skip the Tiers on frames where nothing inside the moon disc changed since the previous frame?
+ * User configurable from settings.cfg
+ */
+bool MOTION_GATE = false;
+/**
+ * Minimum change in value for a pixel inside the moon disc to count towards the change energy.
+ * User configurable from settings.cfg
+ */
+int MOTION_GATE_PIXEL = 15;
+/**
+ * Number of running deviations above the noise floor the change energy must reach to run the Tiers.
+ * User configurable from settings.cfg
+ */
+double MOTION_GATE_K = 4;
+/**
+ * Rate at which the motion gate noise floor follows the change energy (0 to 1).
+ * User configurable from settings.cfg
+ */
+double MOTION_GATE_ALPHA = 0.02;
+/**
+ * Number of frames used to learn the noise floor before any frame is skipped.
+ * User configurable from settings.cfg
+ */
+int MOTION_GATE_WARMUP = 30;
+/**
+ * Toggle to run the Tiers only on the tiles of the frame which changed since the previous frame.
+ * User configurable from settings.cfg
+ */
+bool DIRTY_TILES = false;
+/**
+ * Width and height in pixels of a dirty tile.
+ * User configurable from settings.cfg
+ */
+int TILE_SIZE = 32;
+/**
+ * Minimum change in value for a pixel to count as changed inside a tile.
+ * User configurable from settings.cfg
+ */
+int TILE_PIXEL = 10;
+/**
+ * Number of changed pixels needed to mark a tile dirty.
+ * User configurable from settings.cfg
+ */
+int TILE_MIN_PIXELS = 4;
+/**
+ * Cascade mode: 0 runs every Tier on every frame, 1 runs Tiers 3 and 4 only on frames near a Tier 1
+ * or Tier 2 detection, 2 also runs Tier 3 only in the area around those detections.
+ * User configurable from settings.cfg
+ */
+int CASCADE = 0;
+/**
+ * Number of frames before and after a Tier 1 or Tier 2 detection which also get Tiers 3 and 4.
+ * User configurable from settings.cfg
+ */
+int CASCADE_FRAMES = 2;
+/**
+ * Number of pixels around a Tier 1 or Tier 2 detection searched by Tier 3 when CASCADE = 2.
+ * User configurable from settings.cfg
+ */
+int CASCADE_PAD = 40;
+/**
+ * Run the Tiers on every DECIMATE frames, and on the frames between only when a bird was found in a
+ * neighbouring sampled frame.  1 runs every frame.  Takes priority over CASCADE.
+ * User configurable from settings.cfg
+ */
+int DECIMATE = 1;
+/**
+ * Tier whose detections in a sampled frame get the frames between processed (1 to 4).
+ * User configurable from settings.cfg
+ */
+int DECIMATE_TIER = 1;
+/**
+ * Number of seconds of video between samples in quick look mode (--quick-look).
+ * User configurable from settings.cfg
+ */
+double QUICK_LOOK_STEP = 10;
+/**
+ * Smallest moon area, as a fraction of the calibration frame's, for a quick look sample to count as
+ * visible.
+ * User configurable from settings.cfg
+ */
+double QUICK_LOOK_VISIBLE = 0.8;
+/**
+ * Build (or reuse) a keyframe index of the input video for the quick look and NON_ZERO_START seeks?
+ * User configurable from settings.cfg
+ */
+bool KEYFRAME_INDEX = true;
+/**
+ * Number of frames in a row without the moon before the run ends.  0 keeps going to the end of the
+ * video and picks the moon up again whenever it comes back.
+ * User configurable from settings.cfg
+ */
+int MOON_LOST_LIMIT = 0;
+/**
+ * Downscale factor of the scan which looks for the moon while it is lost
+ * User configurable from settings.cfg
+ */
+int REACQUIRE_SCALE = 4;
+/**
+ * Fraction of the first frame's moon box the scan must see before the moon counts as found again
+ * User configurable from settings.cfg
+ */
+double REACQUIRE_FRACTION = 0.5;
+/**
+ * Frame numbers of the keyframes of the input video, in order.  Empty without an index.
+ */
+vector <int> KEYFRAMES;
+/**
+ * Toggle to link the detections of one Tier across frames into tracks.
+ * User configurable from settings.cfg
+ */
+bool TRACKING = false;
+/**
+ * Tier whose detections are linked into tracks (1 to 4).
+ * User configurable from settings.cfg
+ */
+int TRACK_TIER = 1;
+/**
+ * Largest distance in pixels between a track's predicted position and a detection it is linked to.
+ * User configurable from settings.cfg
+ */
+double TRACK_GATE = 30;
+/**
+ * Number of frames a track may go without a detection before it is closed.
+ * User configurable from settings.cfg
+ */
+int TRACK_MAX_MISSED = 3;
+/**
+ * Number of detections a closed track needs to be written to tracks.csv.
+ * User configurable from settings.cfg
+ */
+int TRACK_MIN_LENGTH = 3;
+/**
+ * Number of detections after which a track is closed, so tracks stay bounded.  0 for no limit.
+ * User configurable from settings.cfg
+ */
+int TRACK_MAX_LENGTH = 300;
+/**
+ * Slowest net movement in pixels per frame for a closed track to be written to tracks.csv.
+ * User configurable from settings.cfg
+ */
+double TRACK_MIN_SPEED = 0.5;
 
 
 /**
@@ -295,6 +580,11 @@ double T1_AT_MAX = 255;
  * User configurable from settings.cfg
  */
 int T1_AT_BLOCKSIZE = 65;
+/**
+ * Use the integral image box mean instead of the Gaussian mean for adaptive threshold for Tier 1.
+ * User configurable from settings.cfg
+ */
+bool T1_AT_BOX = false;
 /**
  * Subtracted constant for adaptive threshold for Tier 1.
  * User configurable from settings.cfg
@@ -317,6 +607,11 @@ double T2_AT_MAX = 255;
  * User configurable from settings.cfg
  */
 int T2_AT_BLOCKSIZE = 65;
+/**
+ * Use the integral image box mean instead of the Gaussian mean for adaptive threshold for Tier 2.
+ * User configurable from settings.cfg
+ */
+bool T2_AT_BOX = false;
 /**
  * Subtracted constant for adaptive threshold for Tier 2.
  * User configurable from settings.cfg
@@ -374,6 +669,22 @@ int T3_CUTOFF_THRESH = 40;
  * User configurable from settings.cfg
  */
 int T3_DYMASK = 45;
+/**
+ * Run Tier 3 in 16-bit fixed point instead of float?
+ * User configurable from settings.cfg
+ */
+bool T3_FIXED_POINT = false;
+/**
+ * Number of fractional bits kept by the fixed point Tier 3 (0 to 14).
+ * User configurable from settings.cfg
+ */
+int T3_FIXED_SHIFT = 2;
+/**
+ * Differing pixels allowed between the fixed point and float Tier 3 masks, as a fraction of the
+ * pixels set in the float mask.
+ * User configurable from settings.cfg
+ */
+double T3_FIXED_TOLERANCE = 0.02;
 
 
 /**
@@ -386,6 +697,11 @@ double T4_AT_MAX = 255;
  * User configurable from settings.cfg
  */
 int T4_AT_BLOCKSIZE = 65;
+/**
+ * Use the integral image box mean instead of the Gaussian mean for adaptive threshold for Tier 4.
+ * User configurable from settings.cfg
+ */
+bool T4_AT_BOX = false;
 /**
  * Subtracted constant for adaptive threshold for Tier 4.
  * User configurable from settings.cfg
@@ -426,6 +742,418 @@ int T4_THINNING = 0;
  * User configurable from settings.cfg
  */
 int T4_DYMASK = 45;
+/**
+ * Toggle to run Tier 5 against the running background model.
+ * User configurable from settings.cfg
+ */
+bool TIER5 = false;
+/**
+ * Rate at which the Tier 5 background follows the video (0 to 1).
+ * User configurable from settings.cfg
+ */
+double T5_ALPHA = 0.05;
+/**
+ * Number of standard deviations from the background for a pixel to be foreground in Tier 5.
+ * User configurable from settings.cfg
+ */
+double T5_K = 4;
+/**
+ * Smallest standard deviation of a background pixel in Tier 5.
+ * User configurable from settings.cfg
+ */
+double T5_MIN_SIGMA = 4;
+/**
+ * Number of frames used to build the Tier 5 background before anything is detected.
+ * User configurable from settings.cfg
+ */
+int T5_WARMUP = 30;
+/**
+ * Width of the dynamic mask application for Tier 5.
+ * User configurable from settings.cfg
+ */
+int T5_DYMASK = 45;
+
+
+// Types
+/**
+ * A single silhouette detected by one of the Tiers.  Each row becomes one line in a Tier*.csv file.
+ */
+struct TierRow {
+	int framecnt;
+	int x;
+	int y;
+	float radius;
+};
+
+/**
+ * The contours of one image in a single point buffer.  Contour i is the spans[i].second points from
+ * points[spans[i].first], so a set costs two allocations however many contours it holds.  A contour
+ * is handed out as a Mat header over its points (CV_32SC2, one column), which every OpenCV contour
+ * function takes, so reading one copies nothing.  The header is valid until the set is changed.
+ */
+class ContourSet {
+public:
+	ContourSet();
+	void assign(const vector <vector<Point>> &contours);
+	size_t size() const;
+	int count(size_t i) const;
+	Mat operator[](size_t i) const;
+	vector <Point> copy(size_t i) const;
+private:
+	vector <Point> points;
+	vector <std::pair<int, int>> spans;
+};
+
+/**
+ * Summary of a Tier on a frame too noisy to process, written to saturated.csv in place of its rows.
+ * The number of contours is 0 if the Tier stopped before finding them, and fill stays 0 unless the
+ * Tier saturated.
+ */
+struct Saturation {
+	size_t blobs = 0;
+	double fill = 0;
+};
+
+/**
+ * Everything the task graph needs to process one centered frame.  The centered frames are shared
+ * read-only between the Tier tasks, and each Tier fills only its own slot of tier_rows.  Tier 5 fills
+ * its slot in the ordered commit step.
+ */
+struct FrameJob {
+	int sequence;
+	int framecnt;
+	bool skip_tiers;
+	bool skip_expensive;
+	Mat frame;
+	Mat old_frame;
+	Mat older_frame;
+	vector <Point> bigone;
+	vector <Rect> regions;
+	vector <TierRow> tier_rows[5];
+	Saturation saturation[5];
+};
+
+/**
+ * A bird followed across frames by the Tracker, with a constant velocity model.
+ */
+struct Track {
+	int start_frame;
+	int last_frame;
+	int start_x;
+	int start_y;
+	float x;
+	float y;
+	float vx;
+	float vy;
+	int hits;
+	double distance;
+	std::string path;
+};
+
+/**
+ * Online tracker which links the detections of one Tier into tracks while the frames are committed,
+ * and writes each finished track as one line of tracks.csv.
+ */
+class Tracker {
+public:
+	Tracker();
+	void update(int framecnt, const vector <TierRow> &rows);
+	void finish();
+private:
+	void close(Track &track);
+	vector <Track> open;
+	int next_id;
+};
+/**
+ * The tracker fed by commit_frame()
+ */
+Tracker TRACKER;
+
+/**
+ * A frame held by the look-back window.
+ */
+struct HeldFrame {
+	int framecnt;
+	Mat frame;
+	vector <Point> bigone;
+	vector <TierRow> rows;
+	Saturation saturation;
+};
+
+class TaskGraph;
+class TaskPool;
+
+/**
+ * The frames of one look-back rescan.  Each frame is rescanned by its own task, and done is set once
+ * they have all finished.
+ */
+struct LookBackBatch {
+	vector <HeldFrame> frames;
+	std::shared_ptr<TaskGraph> graph;
+	std::atomic<bool> done;
+};
+
+/**
+ * Window of the last LOOKBACK_FRAMES committed frames, rescanned with more sensitive settings when a
+ * bird is detected so that the frames before it entered are covered too.
+ */
+class LookBack {
+public:
+	LookBack();
+	void start(TaskPool &workers);
+	void commit(FrameJob &job);
+	void finish();
+private:
+	void write_done();
+	std::deque<HeldFrame> window;
+	std::deque<std::shared_ptr<LookBackBatch>> batches;
+	TaskPool *pool;
+	int last_rescanned;
+};
+/**
+ * The look-back window fed by commit_frame()
+ */
+LookBack LOOKBACK;
+
+/**
+ * Chips of one classifier batch.  The forward pass runs as a task on the pool, and done is set once
+ * scores holds a row per chip (or stays empty if the model failed).
+ */
+struct ClassifyBatch {
+	vector <Mat> chips;
+	vector <std::pair<int, TierRow>> rows;
+	Mat scores;
+	std::shared_ptr<TaskGraph> graph;
+	std::atomic<bool> done;
+};
+
+/**
+ * Second stage classifier which scores the Tier detections with an OpenCV DNN model on the CPU.
+ * Chips from several frames and Tiers are batched into one forward pass, which runs on the pool.
+ */
+class Classifier {
+public:
+	Classifier();
+	int load(std::string model);
+	int check();
+	void start(TaskPool &workers);
+	void add(FrameJob &job);
+	void finish();
+private:
+	int score(const vector <Mat> &chips, Mat &scores);
+	void launch();
+	void write_done();
+	dnn::Net net;
+	std::mutex net_lock;
+	std::shared_ptr<ClassifyBatch> filling;
+	std::deque<std::shared_ptr<ClassifyBatch>> batches;
+	TaskPool *pool;
+};
+/**
+ * The classifier fed by commit_frame()
+ */
+Classifier CLASSIFIER;
+
+/**
+ * Work-stealing thread pool.  Each worker owns a deque of tasks.  Tasks submitted from a worker
+ * are pushed to the back of its own deque and popped from the back (newest first), while idle
+ * workers steal from the front of the other deques (oldest first).
+ */
+class TaskPool {
+public:
+	explicit TaskPool(int workers);
+	~TaskPool();
+	void submit(std::function<void()> task);
+	int size() const;
+private:
+	struct WorkQueue {
+		std::mutex lock;
+		std::deque<std::function<void()>> tasks;
+	};
+	void worker_loop(int index);
+	bool take_task(int index, std::function<void()> &task);
+	vector <std::unique_ptr<WorkQueue>> queues;
+	vector <std::thread> threads;
+	std::mutex idle_lock;
+	std::condition_variable idle_cv;
+	int queued;
+	std::atomic<unsigned int> next_queue;
+	bool stopping;
+};
+
+/**
+ * A small dependency graph of tasks.  A task is handed to the TaskPool once every task it depends
+ * on has finished, so independent tasks (e.g. the four Tiers) run on whichever cores are idle.
+ */
+class TaskGraph : public std::enable_shared_from_this<TaskGraph> {
+public:
+	TaskGraph();
+	int add_task(std::function<void()> work);
+	void add_edge(int before, int after);
+	void launch(TaskPool &pool);
+	void wait();
+private:
+	struct Node {
+		std::function<void()> work;
+		std::atomic<int> pending;
+		vector <int> successors;
+	};
+	void run_task(TaskPool &pool, int index);
+	std::deque<Node> nodes;
+	std::atomic<int> remaining;
+	std::mutex done_lock;
+	std::condition_variable done_cv;
+};
+
+
+/**
+ * Reorder buffer for frames leaving the task graph.  Frames may finish out of order when several are
+ * in flight, so finished FrameJobs are held here until every earlier frame has been committed.
+ */
+class ReorderBuffer {
+public:
+	explicit ReorderBuffer(std::function<void(FrameJob &)> commit);
+	void finish(std::shared_ptr<FrameJob> job);
+private:
+	std::function<void(FrameJob &)> commit;
+	std::mutex lock;
+	std::map<int, std::shared_ptr<FrameJob>> held;
+	int next_sequence;
+	bool committing;
+};
+
+/**
+ * Parts of a frame's work held by a task graph, see frame_graph()
+ */
+enum GraphStage {
+	STAGE_ALL,
+	STAGE_CHEAP,
+	STAGE_EXPENSIVE
+};
+
+/**
+ * Ordered decision step of the cascade mode.  Frames are queued after their cheap stage is launched,
+ * and come out in order once it is known whether they need the expensive stage.
+ */
+class Cascade {
+public:
+	Cascade();
+	void add(std::shared_ptr<FrameJob> job, std::shared_ptr<TaskGraph> cheap);
+	std::shared_ptr<FrameJob> next(bool flush);
+private:
+	std::deque<std::pair<std::shared_ptr<FrameJob>, std::shared_ptr<TaskGraph>>> pending;
+	std::deque<vector <Rect>> past;
+};
+
+/**
+ * Decimated mode.  Every DECIMATE frames is sampled and processed at once, the frames between are
+ * held back until the neighbouring samples show whether they are worth processing.
+ */
+class Decimator {
+public:
+	Decimator();
+	bool sampled();
+	void add(std::shared_ptr<FrameJob> job, std::shared_ptr<TaskGraph> graph);
+	std::shared_ptr<FrameJob> next(bool flush);
+private:
+	std::deque<std::pair<std::shared_ptr<FrameJob>, std::shared_ptr<TaskGraph>>> pending;
+	int added;
+	bool last_hit;
+};
+
+/**
+ * Ring of the last few centered frames, newest first.  Frames are held by reference, so keeping the
+ * history copies no pixels.
+ */
+class FrameHistory {
+public:
+	explicit FrameHistory(size_t depth);
+	void push(Mat frame);
+	Mat back(size_t age) const;
+	void clear();
+private:
+	vector <Mat> frames;
+	size_t newest;
+	size_t count;
+};
+
+/**
+ * Per pixel running Gaussian model of the centered frames, used by Tier 5.
+ */
+class BackgroundModel {
+public:
+	BackgroundModel();
+	Mat apply(Mat in_frame);
+private:
+	Mat mean;
+	Mat variance;
+	int frames;
+};
+/**
+ * The background model used by tier_five()
+ */
+BackgroundModel BACKGROUND;
+
+/** GaussianBlur style function: in, out, kernel size, sigma x, sigma y */
+typedef void (*blur_kernel)(Mat, Mat &, Size, double, double);
+/** Inverted Gaussian adaptiveThreshold style function: in, out, max value, block size, constant */
+typedef void (*threshold_kernel)(Mat, Mat &, double, int, double);
+
+/**
+ * The blur and threshold functions used by bigone and the Tiers.  Filled once at startup by
+ * select_kernels() from the kernel settings in settings.cfg.
+ */
+struct TierKernels {
+	blur_kernel qhe_blur;
+	threshold_kernel t1_threshold;
+	threshold_kernel t2_threshold;
+	blur_kernel t3_blur;
+	threshold_kernel t4_threshold;
+	blur_kernel t4_blur;
+};
+TierKernels KERNELS;
+
+/** Tier filter chain: frame n, n-1 and n-2 in, binary mask out */
+typedef Mat (*tier_chain)(const Mat &, const Mat &, const Mat &);
+
+/**
+ * Scratch images of the filter chains.  Each step of a chain writes into its own named buffer
+ * instead of cloning its input.  A Mat keeps its memory when it is written again at the same size and
+ * type, so the buffers are only reallocated when the region a chain runs on changes size.  A mask
+ * returned by a chain lives in these buffers, so it is valid until the next chain runs on the same
+ * worker.
+ */
+struct TierContext {
+	Mat qhe_blur;
+	Mat qhe_mask;
+	Mat mask;
+	Mat in_lap;
+	Mat old_lap;
+	Mat older_lap;
+	Mat in_blur;
+	Mat old_blur;
+	Mat older_blur;
+	Mat diff;
+	Mat fixed_in;
+	Mat fixed_old;
+	Mat fixed_older;
+	Mat fixed_in_blur;
+	Mat fixed_old_blur;
+	Mat fixed_older_blur;
+	Mat fixed_diff;
+	Mat fixed_mask;
+	Mat grad_x;
+	Mat grad_y;
+	Mat edges;
+	Mat edges_blur;
+	// findContours() output, kept so the point lists reuse their memory, see contours_only()
+	vector <vector<Point>> found;
+	vector <Vec4i> hierarchy;
+};
+/**
+ * Scratch images of the calling worker thread
+ */
+thread_local TierContext SCRATCH;
 
 
 // Declared functions/prototypes
@@ -436,23 +1164,65 @@ static int min_square_dim(Mat in_frame);
 static vector <int> edge_width(vector<Point> contour);
 static vector <int> edge_height(vector<Point> contour);
 static int initial_crop(Mat in_frame, int framecnt);
-static int touching_edges(Mat in_frame, vector<Point> contour);
-static Mat traditional_centering(Mat in_frame, vector <vector<Point>> contours, int largest, Rect box);
+static int touching_edges(Mat in_frame, Mat contour);
+static Mat traditional_centering(Mat in_frame, const ContourSet &contours, int largest, Rect box);
 static int first_frame(Mat in_frame, int framecnt);
 static int halo_noise_and_center(Mat in_frame, int framecnt);
+static bool moon_reacquired(Mat in_frame, int moon_area);
+static int moon_lost_data(int first_frame, int last_frame, bool reacquired);
 static void signal_callback_handler(int signum);
-static Mat apply_dynamic_mask(Mat in_frame, vector<vector<Point>> contours, int maskwidth);
-static int largest_contour(vector <vector<Point>> contours);
-static vector <vector<Point>> contours_only(Mat in_frame);
+static Mat apply_dynamic_mask(Mat in_frame, const vector <Point> &contour, int maskwidth, Point offset);
+static int largest_contour(const ContourSet &contours);
+static ContourSet contours_only(const Mat &in_frame, int method);
 static int box_finder(Mat in_frame, bool do_thresh);
 static int box_data(Rect box, int framecnt);
 static int show_usage(string name);
-static vector <Point> qhe_bigone(Mat in_frame);
-static vector <vector<Point>> quiet_halo_elim(vector <vector<Point>> contours, vector <Point> bigone);
-static int tier_one(int cnt, Mat in_frame, vector <Point> bigone);
-static int tier_two(int cnt, Mat in_frame, vector <Point> bigone);
-static int tier_three(int cnt, Mat in_frame, Mat old_frame, vector <Point> bigone);
-static int tier_four(int cnt, Mat in_frame, Mat old_frame, vector <Point> bigone);
+static void blur_generic(Mat in_frame, Mat &out_frame, Size ksize, double sigma_x, double sigma_y);
+static void recursive_line(float *line, int count, int step, const double *coeffs);
+static void recursive_coeffs(double sigma, double *coeffs);
+static void blur_recursive(Mat in_frame, Mat &out_frame, Size ksize, double sigma_x, double sigma_y);
+static int check_recursive_blur(std::string name, Size ksize, double sigma_x, double sigma_y);
+static void threshold_generic(Mat in_frame, Mat &out_frame, double maxval, int blocksize, double constant);
+static blur_kernel pick_blur(int kernel_x, int kernel_y);
+static void threshold_box(Mat in_frame, Mat &out_frame, double maxval, int blocksize, double constant);
+static threshold_kernel pick_threshold(int blocksize, bool box);
+static int select_kernels(bool check_all);
+static vector <Point> qhe_bigone(const Mat &in_frame);
+static vector <int> quiet_halo_elim(const ContourSet &contours, const vector <Point> &bigone,
+	Point offset);
+static Mat tier_one(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static Mat tier_two(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static Mat tier_three(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static Mat tier_three_fixed(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static int check_fixed_point_tier_three();
+static Mat tier_four(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static int tier_margin(int tier);
+static Rect moon_rect(const vector <Point> &bigone, Size size);
+static Mat region_mask(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame, Rect area,
+	vector <Rect> regions, int margin, tier_chain chain);
+static bool saturated(int framecnt, int tier, size_t blobs, double fill, Saturation &saturation);
+static bool lunar_ellipse(Rect bounds, Rect moon, int maskwidth);
+static Rect moon_bounds(const vector <Point> &bigone, Point offset);
+static int tier_contours(int framecnt, int tier, Mat in_frame, Point offset,
+	const vector <Point> &bigone, int maskwidth, vector <TierRow> &rows, Saturation &saturation);
+static int tier_blobs(int framecnt, int tier, Mat in_frame, Point offset, const vector <Point> &bigone,
+	int maskwidth, vector <TierRow> &rows, Saturation &saturation);
+static int run_tier(int tier, FrameJob &job);
+static int tier_five(FrameJob &job);
+static vector <Rect> dirty_regions(Mat in_frame, Mat old_frame);
+static int write_tier_rows(std::string tierfile, const vector <TierRow> &rows);
+static int write_saturation(const FrameJob &job);
+static Mat tier_lookback(const Mat &in_frame, const Mat &old_frame, const Mat &older_frame);
+static void rescan_frame(HeldFrame &held);
+static void commit_frame(FrameJob &job);
+static bool motion_gate(int framecnt, Mat in_frame, Mat old_frame);
+static vector <Rect> cascade_hits(FrameJob &job);
+static bool frame_hit(FrameJob &job);
+static std::shared_ptr<TaskGraph> frame_graph(std::shared_ptr<FrameJob> job, ReorderBuffer &committer,
+	int stage);
+static int load_keyframe_index(std::string input_file);
+static int nearest_keyframe(int framecnt, bool after);
+static int quick_look(std::string input_file);
 static int parse_checklist(std::string name, std::string value);
 static std::string out_frame_gen(int framecnt);
 std::string space_space(std::string instring);
@@ -460,6 +1230,7 @@ static int generate_slideshow();
 static int concat_tiers();
 static int off_screen_ellipse();
 static int post_processing();
+static void write_headers();
 int main(int argc, char* argv[]); 
 
 #endif
@@ -0,0 +1,137 @@
+# CPP_Birdtracker/models/classifier_stand_in.py - Writes the stand-in classifier model
+# Copyright (C) <2020>  <Wesley T. Honeycutt>
+#
+# This program is free software: you can redistribute it and/or modify
+# it under the terms of the GNU General Public License as published by
+# the Free Software Foundation, either version 3 of the License, or
+# (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License
+# along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+
+##@file classifier_stand_in.py
+##@brief Writes classifier_stand_in.onnx, a stand-in for the bird classifier.
+##
+##The stand-in model is used by the --self-test switch, and for trying out CLASSIFY without a
+##trained model.  It takes a batch of single channel chips of any size (N x 1 x H x W floats)
+##and scores each chip with its mean value, as an N x 1 output.  The file is written in the
+##protobuf wire format by hand, so only the Python standard library is needed.
+##
+##@section example_stand_in Usage Example
+##@verbatim
+##cd models && python3 ./classifier_stand_in.py
+##@endverbatim
+
+# Default imports
+
+def varint(value):
+	"""!
+	Encodes a protobuf varint.
+
+	@param value non-negative int
+	@return bytes of the varint
+	"""
+	out = b""
+	while True:
+		byte = value & 0x7F
+		value >>= 7
+		if value:
+			out += bytes([byte | 0x80])
+		else:
+			return out + bytes([byte])
+
+
+def field_varint(number, value):
+	"""!
+	Encodes a varint field.
+
+	@param number protobuf field number
+	@param value non-negative int
+	@return bytes of the field
+	"""
+	return varint(number << 3) + varint(value)
+
+
+def field_bytes(number, value):
+	"""!
+	Encodes a length delimited field (string, bytes or embedded message).
+
+	@param number protobuf field number
+	@param value str or bytes
+	@return bytes of the field
+	"""
+	if isinstance(value, str):
+		value = value.encode()
+	return varint((number << 3) | 2) + varint(len(value)) + value
+
+
+def tensor_info(name, dims):
+	"""!
+	Encodes a ValueInfoProto of a float tensor.
+
+	@param name name of the tensor
+	@param dims list of dimensions, names (dim_param) or sizes (dim_value)
+	@return bytes of the ValueInfoProto
+	"""
+	shape = b""
+	for dim in dims:
+		if isinstance(dim, str):
+			shape += field_bytes(1, field_bytes(2, dim))
+		else:
+			shape += field_bytes(1, field_varint(1, dim))
+	tensor_type = field_varint(1, 1) + field_bytes(2, shape)
+	return field_bytes(1, name) + field_bytes(2, field_bytes(1, tensor_type))
+
+
+def node(op_type, inputs, outputs, name, attributes=b""):
+	"""!
+	Encodes a NodeProto.
+
+	@param op_type ONNX operator
+	@param inputs list of input tensor names
+	@param outputs list of output tensor names
+	@param name name of the node
+	@param attributes encoded attribute fields
+	@return bytes of the NodeProto
+	"""
+	out = b""
+	for value in inputs:
+		out += field_bytes(1, value)
+	for value in outputs:
+		out += field_bytes(2, value)
+	return out + field_bytes(3, name) + field_bytes(4, op_type) + attributes
+
+
+def int_attribute(name, value):
+	"""!
+	Encodes an attribute field holding an AttributeProto of type INT.
+
+	@param name name of the attribute
+	@param value int value
+	@return bytes of the attribute field
+	"""
+	return field_bytes(5, field_bytes(1, name) + field_varint(3, value) + field_varint(20, 2))
+
+
+graph = (
+	field_bytes(1, node("GlobalAveragePool", ["chips"], ["pooled"], "pool"))
+	+ field_bytes(1, node("Flatten", ["pooled"], ["scores"], "flatten", int_attribute("axis", 1)))
+	+ field_bytes(2, "classifier_stand_in")
+	+ field_bytes(11, tensor_info("chips", ["batch", 1, "height", "width"]))
+	+ field_bytes(12, tensor_info("scores", ["batch", 1]))
+)
+model = (
+	field_varint(1, 7)
+	+ field_bytes(2, "LunAero")
+	+ field_bytes(7, graph)
+	+ field_bytes(8, field_varint(2, 13))
+)
+
+with open("classifier_stand_in.onnx", "wb") as outfile:
+	outfile.write(model)